@@ -0,0 +1,135 @@
+#!/bin/bash
+# Kernel Installer by Alexia Michelle <alexia@goldendoglinux.org>
+# License GNU GPL 3.0 (See License for more Information)
+
+# Benchmark de punta a punta: corre el instalador completo (modo --headless)
+# contra un espejo local file:// con un "kernel" sintético, y con shims en el
+# PATH para make, sudo, dpkg, apt, dnf, rpm, update-grub, etc. No hace falta red
+# ni root, y nada se instala de verdad.
+# Para cada backend de DistroOperations informa cuánto tardó cada fase, según
+# los eventos JSON, así se pueden comparar refactors y detectar regresiones.
+#
+# Uso: bench/run.sh [ruta/al/kernel-installer] [backend ...]
+#   backends: debian linuxmint fedora (por defecto, los tres)
+# Variables:
+#   BENCH_FILES=2000        archivos .c del árbol sintético
+#   BENCH_LINE_DELAY=0      segundos por cada línea "CC" del make simulado
+#   BENCH_INSTALL_DELAY=0   segundos por paquete en dpkg/apt/dnf simulados
+#   BENCH_MISSING=""        dependencias que figuran como no instaladas
+#   BENCH_KEEP=1            no borrar el directorio de trabajo al terminar
+#   BENCH_ARGS=""           opciones extra para el instalador, p. ej. "--direct"
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+installer=$(realpath "${1:-$here/../kernel-installer}")
+[ $# -gt 0 ] && shift
+backends=${*:-debian linuxmint fedora}
+
+files=${BENCH_FILES:-2000}
+version=9.9.9
+work=$(mktemp -d /tmp/kernel-installer-bench.XXXXXX)
+
+cleanup() {
+    if [ -n "$BENCH_KEEP" ]; then
+        echo "Directorio de trabajo: $work"
+    else
+        rm -rf "$work"
+    fi
+}
+trap cleanup EXIT
+
+# Paquetes que piden los distro/*.h; con BENCH_MISSING se puede forzar el camino de instalación
+dpkg_packages="build-essential libncurses-dev bison flex libssl-dev libelf-dev bc tar xz-utils gettext
+libc6-dev fakeroot curl git debhelper libdw-dev rsync locales gawk mokutil openssl"
+
+make_mirror() {
+    local src=$work/src/linux-$version
+    local dirs=(kernel drivers/net drivers/gpu arch/x86/kernel arch/arm/kernel arch/riscv/kernel arch/powerpc/kernel)
+
+    for d in "${dirs[@]}" Documentation/admin-guide scripts; do
+        mkdir -p "$src/$d"
+    done
+    touch "$src/Makefile" "$src/Kconfig" "$src/arch/Kconfig" "$src/Documentation/Kconfig"
+
+    for ((i = 0; i < files; i++)); do
+        echo "$src/${dirs[i % ${#dirs[@]}]}/file$i.c"
+        ((i % 4 == 0)) && echo "$src/Documentation/admin-guide/doc$i.rst"
+    done | xargs touch
+
+    mkdir -p "$work/mirror/v${version%%.*}.x"
+    tar -C "$work/src" -cJf "$work/mirror/v${version%%.*}.x/linux-$version.tar.xz" "linux-$version"
+    (cd "$work/mirror/v${version%%.*}.x" && sha256sum "linux-$version.tar.xz" > sha256sums.asc)
+
+    cat > "$work/mirror/index.html" <<EOF
+<table id="latest"><tr><td id="latest_link">
+<a href="v${version%%.*}.x/linux-$version.tar.xz">$version</a>
+</td></tr></table>
+EOF
+
+    printf 'CONFIG_64BIT=y\nCONFIG_LOCALVERSION=""\nCONFIG_MODULES=y\n' > "$work/config-base"
+
+    for pkg in $dpkg_packages; do
+        case " $BENCH_MISSING " in *" $pkg "*) continue ;; esac
+        printf 'Package: %s\nStatus: install ok installed\nArchitecture: amd64\n\n' "$pkg"
+    done > "$work/dpkg-status"
+}
+
+# Duración de cada fase a partir de los eventos "phase" start/done
+report_phases() {
+    awk -v backend="$1" '
+        match($0, /"ts":[0-9.]+/) {
+            ts = substr($0, RSTART + 5, RLENGTH - 5) + 0
+            if (first == "") first = ts
+        }
+        /"type":"phase"/ {
+            match($0, /"phase":"[^"]*"/)
+            phase = substr($0, RSTART + 9, RLENGTH - 10)
+            if ($0 ~ /"state":"start"/) start[phase] = ts
+            else if ($0 ~ /"state":"done"/ && phase in start)
+                printf "%-10s %-13s %8.3f s\n", backend, phase, ts - start[phase]
+        }
+        /"type":"result"/ {
+            match($0, /"status":"[^"]*"/)
+            status = substr($0, RSTART + 10, RLENGTH - 11)
+            last = ts
+        }
+        END { printf "%-10s %-13s %8.3f s  (%s)\n", backend, "total", last - first, status }
+    ' "$2"
+}
+
+run_backend() {
+    local backend=$1
+    local root=$work/$backend
+
+    mkdir -p "$root/home" "$root/boot" "$root/var/lib" \
+             "$root/etc/initramfs-tools/conf.d" "$root/etc/dracut.conf.d"
+    printf 'ID=%s\nNAME="%s (bench)"\n' "$backend" "$backend" > "$root/os-release"
+
+    env HOME="$root/home" \
+        BENCH_ROOT="$root" \
+        PATH="$here/shims:$PATH" \
+        KERNEL_INSTALLER_MIRROR="file://$work/mirror" \
+        KERNEL_INSTALLER_RELEASES_URL="file://$work/mirror/index.html" \
+        KERNEL_INSTALLER_OS_RELEASE="$root/os-release" \
+        KERNEL_INSTALLER_BASE_CONFIG="$work/config-base" \
+        KERNEL_INSTALLER_DPKG_STATUS="$work/dpkg-status" \
+        "$installer" --headless $BENCH_ARGS > "$root/events.jsonl" 2> "$root/output.log" < /dev/null || true
+
+    report_phases "$backend" "$root/events.jsonl"
+
+    if ! grep -q '"type":"result","status":"ok"' "$root/events.jsonl"; then
+        echo "--- $backend falló, últimas líneas de la salida:" >&2
+        tail -n 20 "$root/output.log" >&2
+        return 1
+    fi
+}
+
+echo "Preparando el espejo local ($files archivos)..."
+make_mirror
+
+failed=0
+for backend in $backends; do
+    run_backend "$backend" || failed=1
+done
+exit $failed
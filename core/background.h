@@ -0,0 +1,208 @@
+// --background: make con límites de CPU y E/S (scope de systemd o nice/ionice),
+// ajustables con + y - mientras compila.
+
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "../distro/common.h"
+
+typedef struct {
+    int cpu_weight;     // systemd CPUWeight (100 = normal)
+    int cpu_percent;    // parte de todas las CPUs, para CPUQuota
+    int io_weight;      // systemd IOWeight (100 = normal)
+    int nice;           // alternativa sin cgroups
+    int ionice;         // clase best-effort, 0 (más prioridad) a 7
+} BackgroundLevel;
+
+static const BackgroundLevel background_levels[] = {
+    { 10,  25,  10, 19, 7 },
+    { 20,  50,  20, 15, 7 },
+    { 50,  75,  50, 10, 5 },
+    { 100, 100, 100, 5, 4 },
+};
+
+#define BACKGROUND_LEVEL_COUNT ((int)(sizeof(background_levels) / sizeof(background_levels[0])))
+#define BACKGROUND_DEFAULT_LEVEL 1
+
+static int background_level = BACKGROUND_DEFAULT_LEVEL;
+static int background_systemd = 0;
+static int background_unit_count = 0;
+static pid_t background_main_pid = 0;
+static char background_error[128] = "";
+
+static long background_cpus() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? cpus : 1;
+}
+
+// ioprio_set no tiene envoltorio en glibc
+static int background_set_ionice(pid_t pid, int level) {
+    const int who_process = 1, class_best_effort = 2;
+    return (int)syscall(SYS_ioprio_set, who_process, (int)pid, (class_best_effort << 13) | level);
+}
+
+// Padre de un proceso según /proc/<pid>/stat (el nombre va entre paréntesis y puede tener espacios)
+static pid_t background_parent_of(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+
+    char line[512];
+    pid_t parent = 0;
+    if (fgets(line, sizeof(line), fp)) {
+        char *end = strrchr(line, ')');
+        int ppid;
+        if (end && sscanf(end + 1, " %*c %d", &ppid) == 1) parent = ppid;
+    }
+    fclose(fp);
+    return parent;
+}
+
+static int background_descends_from_us(pid_t pid) {
+    for (int depth = 0; pid > 1 && depth < 64; depth++) {
+        pid = background_parent_of(pid);
+        if (pid == background_main_pid) return 1;
+    }
+    return 0;
+}
+
+// nice e ionice solo para los make en curso (los descendientes de este proceso).
+// El instalador no se toca: sudo dpkg/rpm, el initramfs y el bootloader van a prioridad normal.
+static void background_apply_nice() {
+    const BackgroundLevel *l = &background_levels[background_level];
+    background_error[0] = '\0';
+
+    DIR *dir = opendir("/proc");
+    if (!dir) return;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        pid_t pid = (pid_t)atoi(entry->d_name);
+        if (pid <= 0 || pid == getpid() || !background_descends_from_us(pid)) continue;
+        if (!background_systemd && setpriority(PRIO_PROCESS, pid, l->nice) != 0 && errno == EACCES) {
+            snprintf(background_error, sizeof(background_error), "%s", _("lowering nice needs root"));
+        }
+        background_set_ionice(pid, l->ionice);
+    }
+    closedir(dir);
+}
+
+static void background_format_properties(char *out, size_t size) {
+    const BackgroundLevel *l = &background_levels[background_level];
+    snprintf(out, size, "CPUWeight=%d CPUQuota=%ld%% IOWeight=%d",
+             l->cpu_weight, l->cpu_percent * background_cpus(), l->io_weight);
+}
+
+// Decide el mecanismo. Se llama una vez al arrancar, antes de cualquier fork.
+void background_init() {
+    if (!build_opts.background) return;
+    background_main_pid = getpid();
+
+    char path[256];
+    snprintf(path, sizeof(path),
+             "/sys/fs/cgroup/user.slice/user-%d.slice/user@%d.service/cgroup.controllers",
+             (int)getuid(), (int)getuid());
+
+    int cpu_delegated = 0;
+    FILE *fp = fopen(path, "r");
+    if (fp) {
+        char line[256];
+        if (fgets(line, sizeof(line), fp)) cpu_delegated = (strstr(line, "cpu") != NULL);
+        fclose(fp);
+    }
+
+    background_systemd = cpu_delegated &&
+        system("systemd-run --user --scope --quiet true > /dev/null 2>&1") == 0;
+
+    if (background_systemd) {
+        printf(_("Background mode: the build runs in a systemd scope with CPU and I/O limits.\n"));
+    } else {
+        printf(_("Background mode: systemd user cgroups unavailable, using nice and ionice.\n"));
+    }
+}
+
+// Prefijo para make: "systemd-run --user --scope ... ionice ... " o "nice ... ionice ... ";
+// "" si no hace falta. ionice también con systemd: IOWeight no tiene efecto si el
+// controlador io no está delegado.
+const char* background_make_prefix() {
+    static char prefix[320];
+    prefix[0] = '\0';
+    if (!build_opts.background) return prefix;
+
+    const BackgroundLevel *l = &background_levels[background_level];
+    if (!background_systemd) {
+        snprintf(prefix, sizeof(prefix), "nice -n %d ionice -c 2 -n %d ", l->nice, l->ionice);
+        return prefix;
+    }
+
+    char properties[128];
+    background_format_properties(properties, sizeof(properties));
+
+    // Un scope por cada make; el nombre lleva el pid principal para encontrarlos todos
+    int len = snprintf(prefix, sizeof(prefix), "systemd-run --user --scope --quiet --collect --unit=kernel-installer-%d-%d-%d",
+                       (int)background_main_pid, (int)getpid(), ++background_unit_count);
+    for (char *p = strtok(properties, " "); p && len < (int)sizeof(prefix); p = strtok(NULL, " ")) {
+        len += snprintf(prefix + len, sizeof(prefix) - len, " -p %s", p);
+    }
+    if (len < (int)sizeof(prefix)) snprintf(prefix + len, sizeof(prefix) - len, " ionice -c 2 -n %d ", l->ionice);
+    return prefix;
+}
+
+// Aplica el nivel actual a las compilaciones en curso
+static void background_apply() {
+    background_apply_nice();
+    if (!background_systemd) return;
+
+    char properties[128];
+    background_format_properties(properties, sizeof(properties));
+
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd),
+             "for unit in $(systemctl --user list-units --plain --no-legend 'kernel-installer-%d-*' "
+             "| awk '{print $1}'); do systemctl --user set-property --runtime \"$unit\" %s; done "
+             "> /dev/null 2>&1",
+             (int)background_main_pid, properties);
+    if (system(cmd) != 0) {
+        snprintf(background_error, sizeof(background_error), "%s", _("could not change the limits"));
+    }
+}
+
+// Tecla en la pantalla de progreso. Devuelve 1 si cambió el nivel.
+int background_handle_key(int ch) {
+    if (!build_opts.background) return 0;
+
+    int level = background_level;
+    if ((ch == '+' || ch == '=') && level < BACKGROUND_LEVEL_COUNT - 1) level++;
+    else if ((ch == '-' || ch == '_') && level > 0) level--;
+    if (level == background_level) return 0;
+
+    background_level = level;
+    background_apply();
+    return 1;
+}
+
+// Texto para la cabecera de la pantalla de progreso
+void background_describe(char *out, size_t size) {
+    if (!build_opts.background) {
+        out[0] = '\0';
+        return;
+    }
+
+    const BackgroundLevel *l = &background_levels[background_level];
+    if (background_systemd) {
+        snprintf(out, size, "%s: CPU %d%% (weight %d), IO weight %d [+/-]%s%s",
+                 _("Background"), l->cpu_percent, l->cpu_weight, l->io_weight,
+                 background_error[0] ? " - " : "", background_error);
+    } else {
+        snprintf(out, size, "%s: nice %d, ionice be/%d [+/-]%s%s",
+                 _("Background"), l->nice, l->ionice,
+                 background_error[0] ? " - " : "", background_error);
+    }
+}
+
+#endif
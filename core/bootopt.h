@@ -0,0 +1,88 @@
+// --boot-optimized: módulos sin depuración y con zstd, initramfs mínimo.
+
+#ifndef BOOTOPT_H
+#define BOOTOPT_H
+
+#include <time.h>
+
+#include "../distro/common.h"
+#include "profile.h"
+
+// Variables de make que se suman a bindeb-pkg/rpm-pkg
+// Si los módulos ya están firmados no se pueden volver a stripear (se perdería la firma);
+// en ese caso el strip se hizo antes de firmar (ver signing.h)
+const char* bootopt_make_vars() {
+    return (build_opts.boot_optimized && !build_opts.presigned_modules) ? "INSTALL_MOD_STRIP=1" : "";
+}
+
+// Módulos comprimidos con zstd al instalarse
+void bootopt_apply_config(const char *source_dir) {
+    if (!build_opts.boot_optimized) return;
+
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && scripts/config --file .config -e MODULE_COMPRESS -d MODULE_COMPRESS_NONE "
+             "-d MODULE_COMPRESS_GZIP -d MODULE_COMPRESS_XZ -e MODULE_COMPRESS_ZSTD -e MODULE_COMPRESS_ALL && "
+             "make %s olddefconfig",
+             source_dir, profile_make_vars());
+    run(cmd);
+
+    if (!config_symbol_enabled(source_dir, "MODULE_COMPRESS_ZSTD")) {
+        printf(_("Warning: this kernel does not support zstd module compression.\n"));
+    }
+}
+
+static DistroOperations *bootopt_active_ops = NULL;
+
+// Si la instalación falla, run() sale sin pasar por bootopt_finish_install
+static void bootopt_cleanup() {
+    if (bootopt_active_ops) bootopt_active_ops->minimal_initramfs(0);
+    bootopt_active_ops = NULL;
+}
+
+// Antes de instalar: el initramfs que genera la instalación del paquete ya sale mínimo,
+// sin tener que regenerarlo después
+void bootopt_begin_install(DistroOperations *ops) {
+    if (!build_opts.boot_optimized || !ops->minimal_initramfs) return;
+
+    static int registered = 0;
+    if (!registered) {
+        atexit(bootopt_cleanup);
+        registered = 1;
+    }
+    ops->minimal_initramfs(1);
+    bootopt_active_ops = ops;
+}
+
+// Después de instalar: se borra la configuración y se registra el tamaño del initramfs
+void bootopt_finish_install(DistroOperations *ops, const char *kernel_version) {
+    if (!bootopt_active_ops) return;
+    bootopt_cleanup();
+
+    char path[512];
+    ops->get_initramfs_path(kernel_version, path, sizeof(path));
+
+    long long bytes = 0;
+    struct stat st;
+    if (stat(path, &st) == 0) bytes = (long long)st.st_size;
+
+    printf(_("Initramfs %s: %.2f MiB\n"), path, bytes / (1024.0 * 1024.0));
+    printf(_("Later rebuilds of this initramfs (dkms, microcode or initramfs-tools updates) "
+             "use the distribution defaults again.\n"));
+
+    const char *home = getenv("HOME");
+    if (!home) return;
+
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    FILE *fp = fopen(log_path, "a");
+    if (!fp) return;
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "%s initramfs=%s bytes=%lld\n", stamp, kernel_version, bytes);
+    fclose(fp);
+}
+
+#endif
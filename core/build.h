@@ -0,0 +1,173 @@
+// Compilación compartida por los distro/*.h: comando make, tiempos y build-stats.log.
+
+#ifndef BUILD_H
+#define BUILD_H
+
+#include <time.h>
+
+#include "../distro/common.h"
+#include "profile.h"
+#include "bootopt.h"
+#include "snapshot.h"
+#include "background.h"
+
+// Arma "cd <fuente> && [systemd-run] [taskset] [fakeroot] make -jN <vars> <target>"
+void format_make_cmd(char *out, size_t size, const char *source_dir,
+                     const char *target, int use_fakeroot) {
+    char jobs[16];
+    char pin[64] = "";
+
+    if (build_opts.jobs > 0) {
+        snprintf(jobs, sizeof(jobs), "%d", build_opts.jobs);
+    } else {
+        snprintf(jobs, sizeof(jobs), "$(nproc)");
+    }
+    if (build_opts.cpu_list) {
+        snprintf(pin, sizeof(pin), "taskset -c %s ", build_opts.cpu_list);
+    }
+
+    snprintf(out, size, "cd %s && %s%s%smake -j%s %s %s %s",
+             source_dir, background_make_prefix(), pin, use_fakeroot ? "fakeroot " : "", jobs,
+             profile_make_vars(), bootopt_make_vars(), target);
+}
+
+// Ruta de la imagen del kernel compilada (arch/x86/boot/bzImage, arch/arm64/boot/Image, ...)
+int get_kernel_image_path(const char *source_dir, char *out, size_t size) {
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "cd %s && make -s image_name 2>/dev/null", source_dir);
+
+    FILE *fp = popen(cmd, "r");
+    if (!fp) return -1;
+
+    char image[256];
+    if (!fgets(image, sizeof(image), fp)) {
+        pclose(fp);
+        return -1;
+    }
+    pclose(fp);
+
+    char *newline = strchr(image, '\n');
+    if (newline) *newline = '\0';
+
+    snprintf(out, size, "%s/%s", source_dir, image);
+    return 0;
+}
+
+void format_duration(long seconds, char *out, size_t size) {
+    snprintf(out, size, "%ldh %02ldm %02lds", seconds / 3600, (seconds % 3600) / 60, seconds % 60);
+}
+
+// Busca la última compilación registrada de otro perfil para la comparación
+int find_previous_build(const char *log_path, const char *profile,
+                        long *seconds, long long *image_bytes, char *version, size_t version_size) {
+    FILE *fp = fopen(log_path, "r");
+    if (!fp) return 0;
+
+    char line[512];
+    int found = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char ver[64], prof[32];
+        long secs;
+        long long bytes;
+        if (sscanf(line, "%*s version=%63s profile=%31s seconds=%ld image_bytes=%lld",
+                   ver, prof, &secs, &bytes) == 4 && strcmp(prof, profile) == 0) {
+            *seconds = secs;
+            *image_bytes = bytes;
+            snprintf(version, version_size, "%s", ver);
+            found = 1;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+void build_report_stats(const char *source_dir, const char *version, long seconds) {
+    char image_path[1024];
+    long long image_bytes = 0;
+    struct stat st;
+
+    if (get_kernel_image_path(source_dir, image_path, sizeof(image_path)) == 0 &&
+        stat(image_path, &st) == 0) {
+        image_bytes = (long long)st.st_size;
+    }
+
+    char duration[64];
+    format_duration(seconds, duration, sizeof(duration));
+    const char *profile = profile_name(build_opts.profile);
+
+    printf("\n========================================\n");
+    printf(_("Build profile: %s\n"), profile);
+    printf(_("Build time: %s\n"), duration);
+    printf(_("Kernel image size: %.2f MiB\n"), image_bytes / (1024.0 * 1024.0));
+
+    const char *home = getenv("HOME");
+    if (!home) return;
+
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+
+    // Comparar contra la última compilación del otro perfil
+    const char *other = (build_opts.profile == PROFILE_OPTIMIZED) ? "default" : "optimized";
+    long prev_seconds;
+    long long prev_bytes;
+    char prev_version[64];
+    if (find_previous_build(log_path, other, &prev_seconds, &prev_bytes,
+                            prev_version, sizeof(prev_version))) {
+        format_duration(prev_seconds, duration, sizeof(duration));
+        printf(_("Last %s build (%s): %s, %.2f MiB\n"),
+               other, prev_version, duration, prev_bytes / (1024.0 * 1024.0));
+    }
+    printf("========================================\n\n");
+
+    // --direct registra su propia línea (ver direct.h); esta es la de las compilaciones empaquetadas
+    if (build_opts.direct) return;
+
+    FILE *fp = fopen(log_path, "a");
+    if (!fp) return;
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "%s version=%s profile=%s seconds=%ld image_bytes=%lld\n",
+            stamp, version, profile, seconds, image_bytes);
+    fclose(fp);
+}
+
+// Compila y empaqueta el kernel (bindeb-pkg, rpm-pkg...) mostrando el progreso.
+// Con el perfil optimizado, si la compilación falla se reintenta con GCC.
+// Devuelve los segundos que llevó la compilación.
+long build_kernel_packages(const char *source_dir, const char *version,
+                           const char *target, int use_fakeroot) {
+    char cmd[2048];
+    time_t start = time(NULL);
+
+    format_make_cmd(cmd, sizeof(cmd), source_dir, target, use_fakeroot);
+    int result = run_build_with_progress(cmd, source_dir);
+
+    if (result != 0 && build_opts.profile == PROFILE_OPTIMIZED) {
+        profile_fallback_to_gcc(source_dir);
+        record_config_hash(source_dir);
+        start = time(NULL);
+        format_make_cmd(cmd, sizeof(cmd), source_dir, target, use_fakeroot);
+        result = run_build_with_progress(cmd, source_dir);
+    }
+
+    // Puede que algo del árbol filtrado (otra arquitectura, Documentation/) hiciera falta
+    if (result != 0 && extract_is_filtered(source_dir)) {
+        extract_restore_full(source_dir);
+        snprintf(cmd, sizeof(cmd), "cd %s && make %s olddefconfig", source_dir, profile_make_vars());
+        run(cmd);
+        record_config_hash(source_dir);
+        start = time(NULL);
+        format_make_cmd(cmd, sizeof(cmd), source_dir, target, use_fakeroot);
+        result = run_build_with_progress(cmd, source_dir);
+    }
+
+    if (result != 0) fail_command(cmd, result);
+
+    long seconds = (long)(time(NULL) - start);
+    build_report_stats(source_dir, version, seconds);
+    return seconds;
+}
+
+#endif
@@ -0,0 +1,194 @@
+// Fases del proceso y checkpoint en ~/kernel_build/checkpoint para retomar donde falló.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "../distro/common.h"
+#include "events.h"
+
+#define CHECKPOINT_FILE "checkpoint"
+
+typedef enum {
+    PHASE_DEPENDENCIES,
+    PHASE_FETCH,
+    PHASE_EXTRACT,
+    PHASE_CONFIGURE,
+    PHASE_BUILD,
+    PHASE_INSTALL,
+    PHASE_BOOTLOADER,
+    PHASE_SECURE_BOOT,
+    PHASE_COUNT
+} Phase;
+
+static const char *phase_names[PHASE_COUNT] = {
+    "dependencies", "fetch", "extract", "configure",
+    "build", "install", "bootloader", "secure-boot"
+};
+
+typedef struct {
+    char path[512];             // vacío = sin checkpoint (modo multi-target)
+    char version[32];
+    char tag[64];
+    char config_sha256[72];
+    char profile[16];           // perfil y preset con los que se configuró
+    char preset[256];
+    unsigned completed;         // bit por fase terminada
+    int current;                // fase en curso, -1 ninguna
+    int failed;                 // fase que falló la última vez, -1 ninguna
+    char failed_command[512];
+} Checkpoint;
+
+Checkpoint checkpoint = { .current = -1, .failed = -1 };
+
+int phase_from_name(const char *name) {
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        if (strcmp(phase_names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+void checkpoint_save() {
+    if (!checkpoint.path[0]) return;
+
+    char tmp_path[600];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", checkpoint.path);
+
+    FILE *fp = fopen(tmp_path, "w");
+    if (!fp) {
+        perror(_("Failed to write checkpoint"));
+        return;
+    }
+
+    fprintf(fp, "version=%s\n", checkpoint.version);
+    fprintf(fp, "tag=%s\n", checkpoint.tag);
+    fprintf(fp, "config_sha256=%s\n", checkpoint.config_sha256);
+    fprintf(fp, "profile=%s\n", checkpoint.profile);
+    fprintf(fp, "preset=%s\n", checkpoint.preset);
+    fprintf(fp, "completed=");
+    int first = 1;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        if (checkpoint.completed & (1u << i)) {
+            fprintf(fp, "%s%s", first ? "" : ",", phase_names[i]);
+            first = 0;
+        }
+    }
+    fprintf(fp, "\n");
+    if (checkpoint.failed >= 0) {
+        fprintf(fp, "failed_phase=%s\n", phase_names[checkpoint.failed]);
+        fprintf(fp, "failed_command=%s\n", checkpoint.failed_command);
+    }
+    fclose(fp);
+
+    // rename() es atómico: nunca queda un checkpoint a medio escribir
+    rename(tmp_path, checkpoint.path);
+}
+
+// Devuelve 1 si había un checkpoint de una ejecución sin terminar
+int checkpoint_load(const char *home) {
+    snprintf(checkpoint.path, sizeof(checkpoint.path), "%s/kernel_build/" CHECKPOINT_FILE, home);
+
+    FILE *fp = fopen(checkpoint.path, "r");
+    if (!fp) return 0;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), fp)) {
+        char *newline = strchr(line, '\n');
+        if (newline) *newline = '\0';
+
+        char *value = strchr(line, '=');
+        if (!value) continue;
+        *value++ = '\0';
+
+        if (strcmp(line, "version") == 0) {
+            snprintf(checkpoint.version, sizeof(checkpoint.version), "%s", value);
+        } else if (strcmp(line, "tag") == 0) {
+            snprintf(checkpoint.tag, sizeof(checkpoint.tag), "%s", value);
+        } else if (strcmp(line, "config_sha256") == 0) {
+            snprintf(checkpoint.config_sha256, sizeof(checkpoint.config_sha256), "%s", value);
+        } else if (strcmp(line, "profile") == 0) {
+            snprintf(checkpoint.profile, sizeof(checkpoint.profile), "%s", value);
+        } else if (strcmp(line, "preset") == 0) {
+            snprintf(checkpoint.preset, sizeof(checkpoint.preset), "%s", value);
+        } else if (strcmp(line, "completed") == 0) {
+            char *saveptr = NULL;
+            for (char *name = strtok_r(value, ",", &saveptr); name; name = strtok_r(NULL, ",", &saveptr)) {
+                int phase = phase_from_name(name);
+                if (phase >= 0) checkpoint.completed |= (1u << phase);
+            }
+        } else if (strcmp(line, "failed_phase") == 0) {
+            checkpoint.failed = phase_from_name(value);
+        } else if (strcmp(line, "failed_command") == 0) {
+            snprintf(checkpoint.failed_command, sizeof(checkpoint.failed_command), "%s", value);
+        }
+    }
+    fclose(fp);
+
+    return checkpoint.version[0] != '\0';
+}
+
+int checkpoint_done(Phase phase) {
+    return (checkpoint.completed & (1u << phase)) != 0;
+}
+
+void checkpoint_begin(Phase phase) {
+    checkpoint.current = phase;
+    event_phase(phase_names[phase], "start");
+}
+
+void checkpoint_complete(Phase phase) {
+    checkpoint.completed |= (1u << phase);
+    checkpoint.current = -1;
+    event_phase(phase_names[phase], "done");
+    if (checkpoint.failed == (int)phase) {
+        checkpoint.failed = -1;
+        checkpoint.failed_command[0] = '\0';
+    }
+    checkpoint_save();
+}
+
+// Invalida una fase y todas las que dependen de ella
+void checkpoint_invalidate_from(Phase phase) {
+    for (int i = phase; i < PHASE_COUNT; i++) {
+        checkpoint.completed &= ~(1u << i);
+    }
+    checkpoint_save();
+}
+
+// Lo llama run() antes de abortar, para saber dónde retomar
+void checkpoint_record_failure(const char *cmd) {
+    if (checkpoint.current >= 0) {
+        event_phase(phase_names[checkpoint.current], "failed");
+    }
+    if (!checkpoint.path[0] || checkpoint.current < 0) return;
+
+    checkpoint.failed = checkpoint.current;
+    snprintf(checkpoint.failed_command, sizeof(checkpoint.failed_command), "%s", cmd);
+    checkpoint_save();
+
+    fprintf(stderr, _("Phase '%s' failed. Run the installer again to resume from this phase.\n"),
+            phase_names[checkpoint.failed]);
+}
+
+// Ejecución terminada: el próximo arranque empieza de cero
+void checkpoint_clear() {
+    if (!checkpoint.path[0]) return;
+    unlink(checkpoint.path);
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    checkpoint.current = -1;
+    checkpoint.failed = -1;
+}
+
+void checkpoint_print_resume() {
+    printf("\n========================================\n");
+    printf(_("Resuming unfinished run for kernel %s%s\n"), checkpoint.version, checkpoint.tag);
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        printf("  %-13s %s\n", phase_names[i], checkpoint_done(i) ? _("done") : _("pending"));
+    }
+    if (checkpoint.failed >= 0) {
+        printf(_("Last failure in phase '%s': %s\n"),
+               phase_names[checkpoint.failed], checkpoint.failed_command);
+    }
+    printf("========================================\n\n");
+}
+
+#endif
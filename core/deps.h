@@ -0,0 +1,206 @@
+// Dependencias: se consulta dpkg/rpm y solo se llama al gestor de paquetes si falta algo.
+
+#ifndef DEPS_H
+#define DEPS_H
+
+#include <time.h>
+#include <sys/wait.h>
+
+#include "../distro/common.h"
+#include "watch.h"
+
+#define DPKG_STATUS_FILE "/var/lib/dpkg/status"
+#define DEPS_MAX_PACKAGES 64
+
+typedef enum {
+    PKGDB_DPKG,
+    PKGDB_RPM
+} PackageDatabase;
+
+static int deps_split(char *buf, char **names, int max) {
+    int n = 0;
+    char *saveptr = NULL;
+    for (char *name = strtok_r(buf, " ", &saveptr); name && n < max; name = strtok_r(NULL, " ", &saveptr)) {
+        names[n++] = name;
+    }
+    return n;
+}
+
+static void deps_join_missing(char **names, const int *installed, int n, char *missing, size_t size) {
+    size_t len = 0;
+    missing[0] = '\0';
+    for (int i = 0; i < n && len < size; i++) {
+        if (!installed[i]) {
+            len += snprintf(missing + len, size - len, "%s%s", len ? " " : "", names[i]);
+        }
+    }
+}
+
+// Recorre las entradas de /var/lib/dpkg/status. Devuelve cuántos paquetes faltan
+// o -1 si no se pudo leer la base (en ese caso se instala todo, como antes).
+int deps_missing_dpkg(const char *packages, char *missing, size_t size) {
+    char buf[1024];
+    char *names[DEPS_MAX_PACKAGES];
+    int installed[DEPS_MAX_PACKAGES] = {0};
+    snprintf(buf, sizeof(buf), "%s", packages);
+    int n = deps_split(buf, names, DEPS_MAX_PACKAGES);
+
+    FILE *fp = fopen(env_or_default("KERNEL_INSTALLER_DPKG_STATUS", DPKG_STATUS_FILE), "r");
+    if (!fp) return -1;
+
+    char line[1024];
+    char package[256] = "";
+    int package_installed = 0;
+    while (1) {
+        int eof = (fgets(line, sizeof(line), fp) == NULL);
+
+        // Una línea vacía (o el final del archivo) cierra la entrada del paquete
+        if (eof || line[0] == '\n') {
+            if (package[0] && package_installed) {
+                for (int i = 0; i < n; i++) {
+                    if (strcmp(names[i], package) == 0) installed[i] = 1;
+                }
+            }
+            package[0] = '\0';
+            package_installed = 0;
+            if (eof) break;
+            continue;
+        }
+
+        if (strncmp(line, "Package: ", 9) == 0) {
+            snprintf(package, sizeof(package), "%.*s", (int)strcspn(line + 9, "\n"), line + 9);
+        } else if (strncmp(line, "Status: ", 8) == 0) {
+            package_installed = (strstr(line, " installed\n") != NULL && strstr(line, "install ok") != NULL);
+        }
+    }
+    fclose(fp);
+
+    deps_join_missing(names, installed, n, missing, size);
+
+    int count = 0;
+    for (int i = 0; i < n; i++) count += !installed[i];
+    return count;
+}
+
+// rpm -q --quiet por paquete: se mira el código de salida y no el mensaje, que rpm
+// traduce según el idioma. El shell imprime solo los que faltan.
+int deps_missing_rpm(const char *packages, char *missing, size_t size) {
+    char buf[1024];
+    char *names[DEPS_MAX_PACKAGES];
+    int installed[DEPS_MAX_PACKAGES];
+    snprintf(buf, sizeof(buf), "%s", packages);
+    int n = deps_split(buf, names, DEPS_MAX_PACKAGES);
+    for (int i = 0; i < n; i++) installed[i] = 1;
+
+    char cmd[1400];
+    snprintf(cmd, sizeof(cmd),
+             "command -v rpm > /dev/null || exit 127; "
+             "for p in %s; do rpm -q --quiet \"$p\" || echo \"$p\"; done",
+             packages);
+    FILE *fp = popen(cmd, "r");
+    if (!fp) return -1;
+
+    char line[512];
+    char name[256];
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%255s", name) == 1) {
+            for (int i = 0; i < n; i++) {
+                if (strcmp(names[i], name) == 0) installed[i] = 0;
+            }
+        }
+    }
+    int status = pclose(fp);
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 127) return -1;  // no hay rpm
+
+    deps_join_missing(names, installed, n, missing, size);
+
+    int count = 0;
+    for (int i = 0; i < n; i++) count += !installed[i];
+    return count;
+}
+
+// Última instalación de dependencias registrada, para estimar el tiempo ahorrado
+static long deps_last_install_seconds(const char *log_path) {
+    FILE *fp = fopen(log_path, "r");
+    if (!fp) return -1;
+
+    char line[512];
+    long seconds = -1;
+    while (fgets(line, sizeof(line), fp)) {
+        long secs;
+        if (sscanf(line, "%*s deps=installed missing=%*d seconds=%ld", &secs) == 1) {
+            seconds = secs;
+        }
+    }
+    fclose(fp);
+    return seconds;
+}
+
+static void deps_log(const char *line) {
+    const char *home = getenv("HOME");
+    if (!home) return;
+
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    FILE *fp = fopen(log_path, "a");
+    if (!fp) return;
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "%s %s\n", stamp, line);
+    fclose(fp);
+}
+
+// Instala solo los paquetes que faltan. La lista se agrega al final de install_cmd,
+// por ejemplo "sudo apt update && sudo apt install -y".
+void deps_install(PackageDatabase db, const char *packages, const char *install_cmd) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    char missing[1024];
+    int count = (db == PKGDB_DPKG) ? deps_missing_dpkg(packages, missing, sizeof(missing))
+                                   : deps_missing_rpm(packages, missing, sizeof(missing));
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long check_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+
+    char line[256];
+    if (count == 0) {
+        const char *home = getenv("HOME");
+        char log_path[512];
+        snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home ? home : ".");
+        long saved = deps_last_install_seconds(log_path);
+
+        if (saved >= 0) {
+            printf(_("All dependencies are installed (checked in %ld ms), skipping the package manager. "
+                     "Last install took %ld s.\n"), check_ms, saved);
+            snprintf(line, sizeof(line), "deps=skipped check_ms=%ld saved_seconds=%ld", check_ms, saved);
+        } else {
+            printf(_("All dependencies are installed (checked in %ld ms), skipping the package manager.\n"),
+                   check_ms);
+            snprintf(line, sizeof(line), "deps=skipped check_ms=%ld", check_ms);
+        }
+        deps_log(line);
+        return;
+    }
+
+    // Sin base de datos legible se instala la lista completa
+    const char *to_install = (count < 0) ? packages : missing;
+    if (count > 0) {
+        printf(_("Missing dependencies: %s\n"), missing);
+    }
+
+    watch_require_root(_("Installing the missing dependencies"));
+
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd), "%s %s", install_cmd, to_install);
+    time_t install_start = time(NULL);
+    run(cmd);
+
+    snprintf(line, sizeof(line), "deps=installed missing=%d seconds=%ld",
+             count, (long)(time(NULL) - install_start));
+    deps_log(line);
+}
+
+#endif
@@ -0,0 +1,173 @@
+// Diálogos con ncurses. Devuelven como whiptail: 0 = Sí, 1 = No / cancelado.
+
+#ifndef DIALOG_H
+#define DIALOG_H
+
+#include <ncurses.h>
+
+#include "../distro/common.h"
+
+#define DIALOG_MAX_LINES 32
+
+static void dialog_start() {
+    initscr();
+    cbreak();
+    noecho();
+    curs_set(0);
+    keypad(stdscr, TRUE);
+    set_escdelay(25);
+
+    if (has_colors()) {
+        start_color();
+        init_pair(1, COLOR_GREEN, COLOR_BLACK);
+        init_pair(2, COLOR_CYAN, COLOR_BLACK);
+        init_pair(3, COLOR_BLACK, COLOR_CYAN);
+    }
+}
+
+static void dialog_end() {
+    endwin();
+}
+
+// Parte el texto en líneas de como mucho width columnas, respetando los '\n'
+static int dialog_wrap(const char *text, char lines[][256], int max_lines, int width) {
+    int n = 0;
+    const char *p = text;
+    if (width > 255) width = 255;
+
+    while (*p && n < max_lines) {
+        int len = 0;
+        int last_space = -1;
+        while (p[len] && p[len] != '\n' && len < width) {
+            if (p[len] == ' ') last_space = len;
+            len++;
+        }
+
+        int cut = len;
+        if (p[len] && p[len] != '\n' && last_space > 0) cut = last_space;
+
+        snprintf(lines[n++], 256, "%.*s", cut, p);
+        p += cut;
+        if (*p == ' ' || *p == '\n') p++;
+    }
+    return n;
+}
+
+// Caja centrada con título y texto. Devuelve la ventana y la fila siguiente al texto.
+static WINDOW* dialog_window(const char *title, const char *text, int extra_rows, int width, int *text_end) {
+    int screen_h, screen_w;
+    getmaxyx(stdscr, screen_h, screen_w);
+    if (width > screen_w - 2) width = screen_w - 2;
+    if (width < 20) width = 20;
+
+    char lines[DIALOG_MAX_LINES][256];
+    int n = dialog_wrap(text, lines, DIALOG_MAX_LINES, width - 4);
+
+    int height = n + extra_rows + 4;
+    if (height > screen_h) height = screen_h;
+    int y = (screen_h - height) / 2;
+    int x = (screen_w - width) / 2;
+    if (y < 0) y = 0;
+    if (x < 0) x = 0;
+
+    erase();
+    refresh();
+
+    WINDOW *win = newwin(height, width, y, x);
+    keypad(win, TRUE);
+    box(win, 0, 0);
+
+    if (has_colors()) wattron(win, COLOR_PAIR(2) | A_BOLD);
+    mvwprintw(win, 0, (width - (int)strlen(title) - 2) / 2, " %s ", title);
+    if (has_colors()) wattroff(win, COLOR_PAIR(2) | A_BOLD);
+
+    for (int i = 0; i < n && 1 + i < height - 1; i++) {
+        mvwprintw(win, 1 + i, 2, "%s", lines[i]);
+    }
+    *text_end = 1 + n;
+    return win;
+}
+
+static void dialog_button(WINDOW *win, int y, int x, const char *label, int selected) {
+    if (selected) wattron(win, has_colors() ? COLOR_PAIR(3) | A_BOLD : A_REVERSE);
+    mvwprintw(win, y, x, "<%s>", label);
+    if (selected) wattroff(win, has_colors() ? COLOR_PAIR(3) | A_BOLD : A_REVERSE);
+}
+
+// Pregunta Sí/No. Flechas o Tab cambian de botón, Enter confirma, Esc equivale a No.
+int dialog_yesno(const char *title, const char *text, int width) {
+    const char *yes = _("Yes");
+    const char *no = _("No");
+    int selected = 0;
+    int result = -1;
+
+    dialog_start();
+    while (result < 0) {
+        int text_end;
+        WINDOW *win = dialog_window(title, text, 1, width, &text_end);
+        int w = getmaxx(win);
+        int buttons_y = text_end + 1;
+
+        int ch;
+        do {
+            dialog_button(win, buttons_y, w / 4 - 2, yes, selected == 0);
+            dialog_button(win, buttons_y, (3 * w) / 4 - 3, no, selected == 1);
+            wrefresh(win);
+
+            ch = wgetch(win);
+            if (ch == KEY_LEFT || ch == KEY_RIGHT || ch == '\t') selected = !selected;
+            else if (ch == '\n' || ch == KEY_ENTER) result = selected;
+            else if (ch == 27) result = 1;
+            else if (ch == 'y' || ch == 'Y' || ch == 's' || ch == 'S') result = 0;
+            else if (ch == 'n' || ch == 'N') result = 1;
+        } while (result < 0 && ch != KEY_RESIZE);
+
+        delwin(win);
+    }
+    dialog_end();
+    return result;
+}
+
+// Menú de opciones. Devuelve el índice elegido o -1 si se canceló con Esc.
+int dialog_menu(const char *title, const char *text, const char **tags, const char **items,
+                int count, int width) {
+    int selected = 0;
+    int result = -2;
+
+    int tag_width = 0;
+    for (int i = 0; i < count; i++) {
+        int len = (int)strlen(tags[i]);
+        if (len > tag_width) tag_width = len;
+    }
+
+    dialog_start();
+    while (result == -2) {
+        int text_end;
+        WINDOW *win = dialog_window(title, text, count + 1, width, &text_end);
+        int w = getmaxx(win);
+        int first_row = text_end + 1;
+
+        int ch;
+        do {
+            for (int i = 0; i < count; i++) {
+                if (i == selected) wattron(win, has_colors() ? COLOR_PAIR(3) | A_BOLD : A_REVERSE);
+                mvwprintw(win, first_row + i, 3, "%-*s  %-*.*s", tag_width, tags[i],
+                          w - tag_width - 8, w - tag_width - 8, items[i]);
+                if (i == selected) wattroff(win, has_colors() ? COLOR_PAIR(3) | A_BOLD : A_REVERSE);
+            }
+            wrefresh(win);
+
+            ch = wgetch(win);
+            if (ch == KEY_UP) selected = (selected + count - 1) % count;
+            else if (ch == KEY_DOWN || ch == '\t') selected = (selected + 1) % count;
+            else if (ch == '\n' || ch == KEY_ENTER) result = selected;
+            else if (ch == 27) result = -1;
+        } while (result == -2 && ch != KEY_RESIZE);
+
+        delwin(win);
+    }
+    dialog_end();
+    return result;
+}
+
+#endif
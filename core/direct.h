@@ -0,0 +1,251 @@
+// --direct: make incremental e instalación directa en /boot, sin paquetes.
+
+#ifndef DIRECT_H
+#define DIRECT_H
+
+#include <dirent.h>
+#include <time.h>
+
+#include "../distro/common.h"
+#include "build.h"
+#include "checkpoint.h"
+#include "footprint.h"
+#include "presets.h"
+
+// Entradas con las que se configuró el árbol por última vez en --direct
+#define DIRECT_INPUTS_MARKER ".kernel-installer-direct"
+
+static void direct_log(const char *home, const char *line) {
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    FILE *fp = fopen(log_path, "a");
+    if (!fp) return;
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "%s %s\n", stamp, line);
+    fclose(fp);
+}
+
+// Lo llama la instalación por paquetes, para poder comparar el ciclo completo
+void record_install_seconds(const char *home, const char *kernel_version, long seconds) {
+    char line[256];
+    snprintf(line, sizeof(line), "install=%s seconds=%ld", kernel_version, seconds);
+    direct_log(home, line);
+}
+
+// El árbol linux-* configurado más reciente: entre vueltas no se cambia de versión
+// aunque kernel.org publique otra (eso obligaría a compilar todo de nuevo)
+static int direct_find_tree(const char *home, char *version, size_t size) {
+    char build_dir[512];
+    snprintf(build_dir, sizeof(build_dir), "%s/kernel_build", home);
+    DIR *dir = opendir(build_dir);
+    if (!dir) return -1;
+
+    time_t newest = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "linux-", 6) != 0) continue;
+
+        char config[1024];
+        struct stat st;
+        snprintf(config, sizeof(config), "%s/%s/.config", build_dir, entry->d_name);
+        if (stat(config, &st) != 0 || st.st_mtime < newest) continue;
+
+        newest = st.st_mtime;
+        snprintf(version, size, "%s", entry->d_name + 6);
+    }
+    closedir(dir);
+    return newest ? 0 : -1;
+}
+
+static int direct_kernel_release(const char *source_dir, char *out, size_t size) {
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "cd %s && make -s kernelrelease 2>/dev/null", source_dir);
+    FILE *fp = popen(cmd, "r");
+    if (!fp) return -1;
+
+    int ok = (fgets(out, size, fp) != NULL);
+    pclose(fp);
+    if (!ok) return -1;
+    out[strcspn(out, "\n")] = '\0';
+    return out[0] ? 0 : -1;
+}
+
+// Perfil, preset (y el contenido del fragmento, si es un archivo) y --boot-optimized:
+// lo que configure_kernel_tree aplica sobre el .config base
+static void direct_format_inputs(char *out, size_t size) {
+    const char *preset = build_opts.preset ? build_opts.preset : "none";
+    char fragment_sha256[72] = "";
+    if (build_opts.preset && preset_is_file(build_opts.preset) &&
+        file_sha256(build_opts.preset, fragment_sha256, sizeof(fragment_sha256)) != 0) {
+        fragment_sha256[0] = '\0';
+    }
+    snprintf(out, size, "profile=%s preset=%s preset_sha256=%s boot_optimized=%d\n",
+             profile_name(build_opts.profile), preset, fragment_sha256, build_opts.boot_optimized);
+}
+
+// Se reconfigura solo si no hay .config o si cambiaron las entradas: así no se pisa
+// lo que el desarrollador haya cambiado a mano con make menuconfig entre vueltas
+static int direct_needs_configure(const char *source_dir) {
+    char path[1024];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/.config", source_dir);
+    if (stat(path, &st) != 0) return 1;
+
+    snprintf(path, sizeof(path), "%s/" DIRECT_INPUTS_MARKER, source_dir);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 1;
+    char saved[512] = "";
+    if (!fgets(saved, sizeof(saved), fp)) saved[0] = '\0';
+    fclose(fp);
+
+    char current[512];
+    direct_format_inputs(current, sizeof(current));
+    return strcmp(saved, current) != 0;
+}
+
+static void direct_save_inputs(const char *source_dir) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/" DIRECT_INPUTS_MARKER, source_dir);
+    FILE *fp = fopen(path, "w");
+    if (!fp) return;
+    char inputs[512];
+    direct_format_inputs(inputs, sizeof(inputs));
+    fputs(inputs, fp);
+    fclose(fp);
+}
+
+// Última instalación por paquetes (la registra record_install_seconds). La compilación
+// no se compara: la empaquetada es desde cero y la de --direct incremental.
+static int direct_last_install(const char *home, long *seconds, char *version, size_t version_size) {
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    FILE *fp = fopen(log_path, "r");
+    if (!fp) return 0;
+
+    char line[512];
+    int found = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char ver[64];
+        long secs;
+        if (sscanf(line, "%*s install=%63s seconds=%ld", ver, &secs) == 2) {
+            *seconds = secs;
+            snprintf(version, version_size, "%s", ver);
+            found = 1;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+static void direct_report(const char *home, const char *kernel_version,
+                          long build_seconds, long install_seconds) {
+    long total = build_seconds + install_seconds;
+    char build[64], install[64], duration[64];
+    format_duration(build_seconds, build, sizeof(build));
+    format_duration(install_seconds, install, sizeof(install));
+    format_duration(total, duration, sizeof(duration));
+
+    printf("\n========================================\n");
+    printf(_("Direct iteration for %s: build %s, install %s, total %s\n"),
+           kernel_version, build, install, duration);
+
+    long last_install;
+    char last_version[64];
+    if (direct_last_install(home, &last_install, last_version, sizeof(last_version))) {
+        format_duration(last_install, duration, sizeof(duration));
+        printf(_("Last package install (%s): %s\n"), last_version, duration);
+        if (last_install > install_seconds) {
+            format_duration(last_install - install_seconds, duration, sizeof(duration));
+            printf(_("Saved on the install step: %s\n"), duration);
+        }
+    }
+    printf("========================================\n\n");
+
+    char line[256];
+    snprintf(line, sizeof(line), "direct=%s build_seconds=%ld install_seconds=%ld seconds=%ld",
+             kernel_version, build_seconds, install_seconds, total);
+    direct_log(home, line);
+}
+
+// Configura (si hace falta), compila de forma incremental e instala sin paquetes.
+// Sin checkpoint: cada vuelta recompila lo que cambió.
+void run_direct_target(const char *home, DistroOperations *ops, Distro distro, const char *tag,
+                       char *full_kernel_version, size_t full_kernel_version_size) {
+    if (!ops->install_image) {
+        fprintf(stderr, _("--direct is not supported on %s.\n"), ops->name);
+        exit(EXIT_FAILURE);
+    }
+
+    char version[32];
+    if (direct_find_tree(home, version, sizeof(version)) == 0) {
+        printf(_("Reusing the kernel tree for %s (incremental build).\n"), version);
+        char tree[512];
+        snprintf(tree, sizeof(tree), "%s/kernel_build/linux-%s", home, version);
+        snapshot_break_links(tree);
+    } else {
+        printf(_("Fetching latest kernel version from kernel.org...\n"));
+        if (fetch_kernel_version("stable", version, sizeof(version)) != 0) {
+            fprintf(stderr, _("Could not fetch latest kernel version.\n"));
+            exit(EXIT_FAILURE);
+        }
+        checkpoint_begin(PHASE_FETCH);
+        fetch_kernel_source(home, version);
+        checkpoint_complete(PHASE_FETCH);
+    }
+
+    char source_dir[512];
+    snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, version);
+
+    // kconfig solo marca como cambiados los símbolos que cambiaron: make recompila lo justo
+    checkpoint_begin(PHASE_CONFIGURE);
+    if (direct_needs_configure(source_dir)) {
+        configure_kernel_tree(home, version, tag);
+        direct_save_inputs(source_dir);
+    } else {
+        printf(_("Keeping the current .config (same profile and preset as the last iteration).\n"));
+    }
+    checkpoint_complete(PHASE_CONFIGURE);
+
+    // El modelo de espacio es el de una compilación completa: una vuelta incremental
+    // usa mucho menos y, si se registrara, arrastraría el ratio aprendido al mínimo
+    int full_build = !is_kernel_built(source_dir, version, tag);
+    char build_dir[512];
+    Footprint footprint;
+    snprintf(build_dir, sizeof(build_dir), "%s/kernel_build", home);
+    if (full_build) {
+        footprint_estimate(home, version, source_dir, footprint_format(distro), &footprint);
+        footprint_preflight(build_dir, &footprint);
+    }
+
+    checkpoint_begin(PHASE_BUILD);
+    if (full_build) footprint_begin(build_dir);
+    long build_seconds = build_kernel_packages(source_dir, version, "all", 0);
+    if (full_build) footprint_finish(home, version, &footprint);
+    checkpoint_complete(PHASE_BUILD);
+
+    if (direct_kernel_release(source_dir, full_kernel_version, full_kernel_version_size) != 0) {
+        snprintf(full_kernel_version, full_kernel_version_size, "%s%s", version, tag);
+    }
+
+    checkpoint_begin(PHASE_INSTALL);
+    time_t start = time(NULL);
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd), "cd %s && sudo make %s %s modules_install",
+             source_dir, profile_make_vars(), bootopt_make_vars());
+    run(cmd);
+    bootopt_begin_install(ops);
+    ops->install_image(source_dir, full_kernel_version);
+    bootopt_finish_install(ops, full_kernel_version);
+    checkpoint_complete(PHASE_INSTALL);
+
+    checkpoint_begin(PHASE_BOOTLOADER);
+    ops->update_bootloader();
+    checkpoint_complete(PHASE_BOOTLOADER);
+
+    direct_report(home, full_kernel_version, build_seconds, (long)(time(NULL) - start));
+}
+
+#endif
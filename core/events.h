@@ -0,0 +1,215 @@
+// Eventos de progreso en JSON lines (--headless por stdout, --progress-socket).
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../distro/common.h"
+
+#define EVENTS_MAX_CLIENTS 8
+
+static int events_stdout_fd = -1;
+static int events_listen_fd = -1;
+static int events_clients[EVENTS_MAX_CLIENTS];
+static int events_client_count = 0;
+static int events_result_sent = 0;
+static char events_socket_path[108] = "";
+
+void events_accept_clients() {
+    if (events_listen_fd < 0) return;
+
+    int fd;
+    while ((fd = accept4(events_listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        if (events_client_count == EVENTS_MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        events_clients[events_client_count++] = fd;
+    }
+}
+
+void events_send(const char *json) {
+    if (events_stdout_fd < 0 && events_listen_fd < 0) return;
+
+    char line[2048];
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    int len = snprintf(line, sizeof(line), "{\"ts\":%ld.%03ld,%s}\n",
+                       (long)ts.tv_sec, ts.tv_nsec / 1000000, json);
+    // Un objeto cortado no es JSON válido: si no entra, el evento no se publica
+    if (len < 0 || len >= (int)sizeof(line)) return;
+
+    for (int off = 0; events_stdout_fd >= 0 && off < len; ) {
+        ssize_t w = write(events_stdout_fd, line + off, len - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) {
+            events_stdout_fd = -1;
+            break;
+        }
+        off += w;
+    }
+
+    events_accept_clients();
+    for (int i = 0; i < events_client_count; ) {
+        ssize_t r = send(events_clients[i], line, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (r != len) {
+            // Desconectado, o con el buffer lleno: el resto de la línea se perdería
+            // y el próximo evento quedaría pegado a ella
+            close(events_clients[i]);
+            events_clients[i] = events_clients[--events_client_count];
+            continue;
+        }
+        i++;
+    }
+}
+
+// Copia un texto escapándolo para JSON
+void json_escape(const char *in, char *out, size_t size) {
+    size_t j = 0;
+    for (size_t i = 0; in[i] && j + 7 < size; i++) {
+        unsigned char c = (unsigned char)in[i];
+        if (c == '"' || c == '\\') {
+            out[j++] = '\\';
+            out[j++] = c;
+        } else if (c == '\n') {
+            out[j++] = '\\';
+            out[j++] = 'n';
+        } else if (c < 0x20) {
+            j += snprintf(out + j, size - j, "\\u%04x", c);
+        } else {
+            out[j++] = c;
+        }
+    }
+    out[j] = '\0';
+}
+
+void event_phase(const char *phase, const char *state) {
+    char json[256];
+    snprintf(json, sizeof(json), "\"type\":\"phase\",\"phase\":\"%s\",\"state\":\"%s\"", phase, state);
+    events_send(json);
+}
+
+void event_progress(const char *target, int count, int total) {
+    int percent = (count * 100) / (total > 0 ? total : 1);
+    if (percent > 100) percent = 100;
+
+    char json[256];
+    snprintf(json, sizeof(json),
+             "\"type\":\"progress\",\"target\":\"%s\",\"count\":%d,\"total\":%d,\"percent\":%d",
+             target ? target : "", count, total, percent);
+    events_send(json);
+}
+
+// El mensaje escapado se acota para que el evento completo siempre entre en events_send
+void event_message(const char *type, const char *message) {
+    char escaped[1536];
+    char json[1800];
+    json_escape(message, escaped, sizeof(escaped));
+    snprintf(json, sizeof(json), "\"type\":\"%s\",\"message\":\"%s\"", type, escaped);
+    events_send(json);
+}
+
+void event_result(const char *status, const char *kernel) {
+    char json[512];
+    snprintf(json, sizeof(json), "\"type\":\"result\",\"status\":\"%s\",\"kernel\":\"%s\"",
+             status, kernel ? kernel : "");
+    events_send(json);
+    events_result_sent = 1;
+}
+
+// Las líneas de make que parecen errores se publican como eventos "error"
+int is_error_line(const char *line) {
+    return strstr(line, "error:") || strstr(line, "Error ") || strstr(line, "*** ");
+}
+
+int events_enabled() {
+    return events_stdout_fd >= 0 || events_listen_fd >= 0;
+}
+
+// Convierte una línea de la salida de make en eventos. count ya incluye la línea
+// actual; el progreso solo se publica cuando cambia el porcentaje, para no
+// inundar a los clientes.
+void event_build_line(const char *target, const char *line, int count, int total, int *last_percent) {
+    if (!events_enabled()) return;
+
+    if (is_compile_line(line)) {
+        int percent = (count * 100) / (total > 0 ? total : 1);
+        if (percent != *last_percent) {
+            *last_percent = percent;
+            event_progress(target, count, total);
+        }
+    } else if (is_error_line(line)) {
+        event_message("error", line);
+    } else if (strstr(line, "dpkg-deb: building package") || strstr(line, "Wrote: ")) {
+        event_message("status", line);
+    }
+}
+
+void events_shutdown() {
+    if (!events_result_sent) {
+        event_result("failed", NULL);
+    }
+    for (int i = 0; i < events_client_count; i++) close(events_clients[i]);
+    events_client_count = 0;
+    if (events_listen_fd >= 0) {
+        close(events_listen_fd);
+        events_listen_fd = -1;
+        unlink(events_socket_path);
+    }
+}
+
+// Para los procesos hijos (multi-target): no publican eventos ni cierran el socket del padre
+void events_detach() {
+    for (int i = 0; i < events_client_count; i++) close(events_clients[i]);
+    events_client_count = 0;
+    if (events_listen_fd >= 0) close(events_listen_fd);
+    if (events_stdout_fd >= 0) close(events_stdout_fd);
+    events_listen_fd = -1;
+    events_stdout_fd = -1;
+    events_result_sent = 1;
+}
+
+// Prepara las salidas de eventos. Con stdout, el resto de la salida del programa
+// (y de los comandos que ejecuta) se redirige a stderr para no mezclarse con el JSON.
+int events_init(int to_stdout, const char *socket_path) {
+    if (to_stdout) {
+        fflush(stdout);
+        events_stdout_fd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+
+    if (socket_path) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+            fprintf(stderr, _("Socket path too long: %s\n"), socket_path);
+            return -1;
+        }
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+        snprintf(events_socket_path, sizeof(events_socket_path), "%s", socket_path);
+        unlink(socket_path);
+
+        events_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (events_listen_fd < 0 ||
+            bind(events_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+            listen(events_listen_fd, EVENTS_MAX_CLIENTS) != 0) {
+            perror(_("Failed to create progress socket"));
+            if (events_listen_fd >= 0) close(events_listen_fd);
+            events_listen_fd = -1;
+            return -1;
+        }
+    }
+
+    if (events_stdout_fd >= 0 || events_listen_fd >= 0) {
+        atexit(events_shutdown);
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,138 @@
+// Extracción del tarball, filtrada a la arquitectura del equipo cuando se puede.
+
+#ifndef EXTRACT_H
+#define EXTRACT_H
+
+#include <time.h>
+#include <sys/utsname.h>
+
+#include "../distro/common.h"
+
+#define EXTRACT_FILTERED_MARKER ".kernel-installer-filtered"
+
+static const char *kernel_arches[] = {
+    "alpha", "arc", "arm", "arm64", "csky", "hexagon", "ia64", "loongarch", "m68k",
+    "microblaze", "mips", "nios2", "openrisc", "parisc", "powerpc", "riscv", "s390",
+    "sh", "sparc", "um", "x86", "xtensa", NULL
+};
+
+// Nombre del directorio arch/ del kernel para la máquina actual, NULL si no lo conocemos
+const char* host_srcarch() {
+    static struct utsname uts;
+    if (uname(&uts) != 0) return NULL;
+
+    const char *m = uts.machine;
+    if (strcmp(m, "x86_64") == 0 || (m[0] == 'i' && strcmp(m + 2, "86") == 0)) return "x86";
+    if (strcmp(m, "aarch64") == 0) return "arm64";
+    if (strncmp(m, "arm", 3) == 0) return "arm";
+    if (strncmp(m, "riscv", 5) == 0) return "riscv";
+    if (strncmp(m, "ppc", 3) == 0) return "powerpc";
+    if (strncmp(m, "s390", 4) == 0) return "s390";
+    if (strncmp(m, "loongarch", 9) == 0) return "loongarch";
+    return NULL;
+}
+
+// Los dts de arm64 incluyen archivos de arch/arm (scripts/dtc/include-prefixes)
+static int extract_keep_arch(const char *arch, const char *host) {
+    if (strcmp(arch, host) == 0) return 1;
+    return strcmp(host, "arm64") == 0 && strcmp(arch, "arm") == 0;
+}
+
+int extract_is_filtered(const char *source_dir) {
+    char path[1024];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/" EXTRACT_FILTERED_MARKER, source_dir);
+    return stat(path, &st) == 0;
+}
+
+static long extract_count_files(const char *source_dir) {
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "find %s | wc -l", source_dir);
+    FILE *fp = popen(cmd, "r");
+    if (!fp) return 0;
+    char buf[32] = "";
+    if (!fgets(buf, sizeof(buf), fp)) buf[0] = '\0';
+    pclose(fp);
+    return atol(buf);
+}
+
+static void extract_log(const char *source_dir, const char *mode, long seconds) {
+    long files = extract_count_files(source_dir);
+    printf(_("Source tree ready: %ld files (%s) in %ld s.\n"), files, mode, seconds);
+
+    const char *home = getenv("HOME");
+    if (!home) return;
+
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    FILE *fp = fopen(log_path, "a");
+    if (!fp) return;
+
+    const char *name = strrchr(source_dir, '/');
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "%s extract=%s mode=%s files=%ld seconds=%ld\n",
+            stamp, name ? name + 1 : source_dir, mode, files, seconds);
+    fclose(fp);
+}
+
+// Directorio donde está el tarball (y donde se extrae)
+static void extract_parent_dir(const char *source_dir, char *out, size_t size) {
+    const char *slash = strrchr(source_dir, '/');
+    if (slash && slash != source_dir) snprintf(out, size, "%.*s", (int)(slash - source_dir), source_dir);
+    else snprintf(out, size, "%s", slash ? "/" : ".");
+}
+
+// Extrae el tarball completo en source_dir (el nombre del directorio tiene que
+// coincidir con el de adentro del tarball)
+void extract_source_full(const char *tarball, const char *source_dir) {
+    char cmd[2048];
+    char parent[512];
+    extract_parent_dir(source_dir, parent, sizeof(parent));
+    time_t start = time(NULL);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s && tar -C %s -xf %s",
+             source_dir, parent, tarball);
+    run(cmd);
+    extract_log(source_dir, "full", (long)(time(NULL) - start));
+}
+
+// Extrae solo lo necesario para la arquitectura del equipo. Devuelve 0 si pudo.
+int extract_source_filtered(const char *tarball, const char *source_dir) {
+    const char *host = host_srcarch();
+    if (!host) return -1;
+
+    const char *name = strrchr(source_dir, '/');
+    name = name ? name + 1 : source_dir;
+
+    char parent[512];
+    extract_parent_dir(source_dir, parent, sizeof(parent));
+
+    char cmd[4096];
+    int len = snprintf(cmd, sizeof(cmd), "tar -C %s -xf %s --wildcards", parent, tarball);
+    for (int i = 0; kernel_arches[i] && len < (int)sizeof(cmd); i++) {
+        if (extract_keep_arch(kernel_arches[i], host)) continue;
+        len += snprintf(cmd + len, sizeof(cmd) - len, " --exclude='%s/arch/%s'", name, kernel_arches[i]);
+    }
+    if (len < (int)sizeof(cmd)) {
+        // '*' también abarca '/': queda el primer nivel de Documentation/ (Kconfig, Makefile...)
+        len += snprintf(cmd + len, sizeof(cmd) - len, " --exclude='%s/Documentation/*/*'", name);
+    }
+    if (len >= (int)sizeof(cmd)) return -1;
+
+    time_t start = time(NULL);
+    printf("\n %s: %s\n", _("Running"), cmd);
+    if (system(cmd) != 0) return -1;
+
+    char marker[1024];
+    snprintf(marker, sizeof(marker), "%s/" EXTRACT_FILTERED_MARKER, source_dir);
+    FILE *fp = fopen(marker, "w");
+    if (!fp) return -1;
+    fprintf(fp, "arch=%s\n", host);
+    fclose(fp);
+
+    extract_log(source_dir, "filtered", (long)(time(NULL) - start));
+    return 0;
+}
+
+#endif
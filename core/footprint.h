@@ -0,0 +1,345 @@
+// Estimación de disco e inodos antes de compilar y registro del pico real.
+
+#ifndef FOOTPRINT_H
+#define FOOTPRINT_H
+
+#include <sys/statvfs.h>
+#include <time.h>
+
+#include "../distro/common.h"
+#include "dialog.h"
+#include "events.h"
+
+// Valores en KiB por unidad, medidos sobre configs de distro (x86_64, GCC).
+// Son aproximados a propósito: la corrección con el historial hace el resto.
+#define FOOTPRINT_BASE_KB            (512 * 1024)
+#define FOOTPRINT_BASE_DEBUG_KB      (3 * 1024 * 1024)
+#define FOOTPRINT_MODULE_KB          700
+#define FOOTPRINT_MODULE_DEBUG_KB    (5 * 1024)
+#define FOOTPRINT_BUILTIN_KB         60
+#define FOOTPRINT_BUILTIN_DEBUG_KB   400
+// Staging del paquete más el paquete comprimido, por módulo (el -dbg va aparte)
+#define FOOTPRINT_PACKAGE_MODULE_KB  400
+#define FOOTPRINT_PACKAGE_DEBUG_KB   (3 * 1024)
+#define FOOTPRINT_PACKAGE_BASE_KB    (200 * 1024)
+// Lo que queda en /lib/modules por módulo instalado, con y sin strip
+#define FOOTPRINT_INSTALLED_KB       250
+#define FOOTPRINT_INSTALLED_STRIP_KB 120
+#define FOOTPRINT_INSTALLED_DEBUG_KB (3 * 1024)
+// Imagen, initramfs, System.map y config en /boot
+#define FOOTPRINT_BOOT_KB            (160 * 1024)
+#define FOOTPRINT_BOOT_MINIMAL_KB    (80 * 1024)
+#define FOOTPRINT_BASE_INODES        30000
+#define FOOTPRINT_MODULE_INODES      12
+#define FOOTPRINT_BUILTIN_INODES     5
+
+typedef struct {
+    int modules;                    // símbolos =m en la .config
+    int builtins;                   // símbolos =y
+    int debug;                      // CONFIG_DEBUG_INFO
+    const char *format;             // "deb", "rpm" o "direct"
+    unsigned long long model_kb;    // crecimiento de ~/kernel_build según el modelo
+    unsigned long long model_inodes;
+    double ratio;                   // pico real / modelo en compilaciones anteriores
+    double inode_ratio;
+    unsigned long long build_kb;    // ya corregidos con ratio
+    unsigned long long build_inodes;
+    unsigned long long modules_kb;  // /lib/modules
+    unsigned long long boot_kb;
+} Footprint;
+
+// Medición en curso: lo que ocupaba el sistema de archivos de ~/kernel_build al empezar y el máximo visto
+static struct {
+    int active;
+    char path[512];
+    unsigned long long start_kb, start_inodes;
+    unsigned long long peak_kb, peak_inodes;
+    time_t last_sample;
+} footprint_usage;
+
+const char* footprint_format(Distro distro) {
+    if (build_opts.direct) return "direct";
+    return distro == DISTRO_FEDORA ? "rpm" : "deb";
+}
+
+static void footprint_read_config(const char *source_dir, Footprint *fp) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/.config", source_dir);
+    FILE *config = fopen(path, "r");
+    if (!config) return;
+
+    char line[512];
+    while (fgets(line, sizeof(line), config)) {
+        if (strncmp(line, "CONFIG_", 7) != 0) continue;
+        size_t len = strcspn(line, "\n");
+        if (len < 2 || line[len - 2] != '=') continue;
+        if (line[len - 1] == 'm') fp->modules++;
+        else if (line[len - 1] == 'y') fp->builtins++;
+        if (strcmp(line, "CONFIG_DEBUG_INFO=y\n") == 0) fp->debug = 1;
+    }
+    fclose(config);
+}
+
+// Proporción pico/modelo de la última compilación del mismo tipo; si hay una de
+// la misma serie (6.12, 6.6...) se prefiere esa, porque el tamaño crece con las versiones
+static void footprint_learned_ratio(const char *home, const char *version, Footprint *fp) {
+    fp->ratio = 1.0;
+    fp->inode_ratio = 1.0;
+
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    FILE *log = fopen(log_path, "r");
+    if (!log) return;
+
+    char series[32];
+    snprintf(series, sizeof(series), "%s", version);
+    char *dot = strchr(series, '.');
+    if (dot && (dot = strchr(dot + 1, '.')) != NULL) *dot = '\0';
+
+    char line[512];
+    int found_series = 0;
+    while (fgets(line, sizeof(line), log)) {
+        char ver[128], format[16];
+        int debug;
+        unsigned long long model_kb, peak_kb, model_inodes, peak_inodes;
+        if (sscanf(line, "%*s footprint=%127s format=%15s debug=%d model_kb=%llu peak_kb=%llu "
+                         "model_inodes=%llu peak_inodes=%llu",
+                   ver, format, &debug, &model_kb, &peak_kb, &model_inodes, &peak_inodes) != 7) continue;
+        if (strcmp(format, fp->format) != 0 || debug != fp->debug || model_kb == 0 || peak_kb == 0) continue;
+
+        int same_series = (strncmp(ver, series, strlen(series)) == 0 &&
+                           (ver[strlen(series)] == '.' || ver[strlen(series)] == '\0'));
+        if (found_series && !same_series) continue;
+        found_series |= same_series;
+
+        // Una medición rara (otro proceso llenando el disco) no debe disparar la estimación
+        fp->ratio = (double)peak_kb / model_kb;
+        if (fp->ratio < 0.25) fp->ratio = 0.25;
+        if (fp->ratio > 4.0) fp->ratio = 4.0;
+        if (model_inodes && peak_inodes) {
+            fp->inode_ratio = (double)peak_inodes / model_inodes;
+            if (fp->inode_ratio < 0.25) fp->inode_ratio = 0.25;
+            if (fp->inode_ratio > 4.0) fp->inode_ratio = 4.0;
+        }
+    }
+    fclose(log);
+}
+
+// Estima el crecimiento a partir de la .config ya generada en source_dir
+void footprint_estimate(const char *home, const char *version, const char *source_dir,
+                        const char *format, Footprint *fp) {
+    memset(fp, 0, sizeof(*fp));
+    fp->format = format;
+    footprint_read_config(source_dir, fp);
+
+    unsigned long long kb = fp->debug ? FOOTPRINT_BASE_DEBUG_KB : FOOTPRINT_BASE_KB;
+    kb += (unsigned long long)fp->modules * (fp->debug ? FOOTPRINT_MODULE_DEBUG_KB : FOOTPRINT_MODULE_KB);
+    kb += (unsigned long long)fp->builtins * (fp->debug ? FOOTPRINT_BUILTIN_DEBUG_KB : FOOTPRINT_BUILTIN_KB);
+    unsigned long long inodes = FOOTPRINT_BASE_INODES +
+        (unsigned long long)fp->modules * FOOTPRINT_MODULE_INODES +
+        (unsigned long long)fp->builtins * FOOTPRINT_BUILTIN_INODES;
+
+    // --direct no empaqueta; deb y rpm dejan el staging y el paquete, y con
+    // DEBUG_INFO bindeb-pkg arma además linux-image-*-dbg
+    if (strcmp(format, "direct") != 0) {
+        kb += FOOTPRINT_PACKAGE_BASE_KB + (unsigned long long)fp->modules *
+              (fp->debug ? FOOTPRINT_PACKAGE_DEBUG_KB : FOOTPRINT_PACKAGE_MODULE_KB);
+        inodes += (unsigned long long)fp->modules * 2;
+    }
+    fp->model_kb = kb;
+    fp->model_inodes = inodes;
+
+    footprint_learned_ratio(home, version, fp);
+    fp->build_kb = (unsigned long long)(kb * fp->ratio);
+    fp->build_inodes = (unsigned long long)(inodes * fp->inode_ratio);
+
+    int strip = build_opts.boot_optimized && !build_opts.presigned_modules;
+    fp->modules_kb = (unsigned long long)fp->modules *
+        (strip ? FOOTPRINT_INSTALLED_STRIP_KB : fp->debug ? FOOTPRINT_INSTALLED_DEBUG_KB : FOOTPRINT_INSTALLED_KB);
+    fp->boot_kb = build_opts.boot_optimized ? FOOTPRINT_BOOT_MINIMAL_KB : FOOTPRINT_BOOT_KB;
+}
+
+// Para --targets: se compilan todas a la vez, así que cuenta la suma
+void footprint_add(Footprint *total, const Footprint *fp) {
+    if (!total->format) total->format = fp->format;
+    total->modules += fp->modules;
+    total->builtins += fp->builtins;
+    total->debug |= fp->debug;
+    total->model_kb += fp->model_kb;
+    total->model_inodes += fp->model_inodes;
+    total->build_kb += fp->build_kb;
+    total->build_inodes += fp->build_inodes;
+    total->modules_kb += fp->modules_kb;
+    total->boot_kb += fp->boot_kb;
+}
+
+static void footprint_format_size(unsigned long long kb, char *out, size_t size) {
+    if (kb >= 1024 * 1024) snprintf(out, size, "%.1f GiB", kb / (1024.0 * 1024.0));
+    else snprintf(out, size, "%llu MiB", kb / 1024);
+}
+
+typedef struct {
+    const char *path;
+    dev_t dev;
+    unsigned long long need_kb, need_inodes;
+} FootprintCheck;
+
+// Compara con lo libre en cada sistema de archivos (sumando si /boot o
+// /lib/modules están en el mismo que ~/kernel_build). Si no alcanza, se niega a
+// compilar: con --headless sale con error, en modo interactivo pregunta.
+void footprint_preflight(const char *build_dir, const Footprint *fp) {
+    FootprintCheck checks[3] = {
+        { build_dir,      0, fp->build_kb,   fp->build_inodes },
+        { "/lib/modules", 0, fp->modules_kb, (unsigned long long)fp->modules * 2 },
+        { "/boot",        0, fp->boot_kb,    8 },
+    };
+    int n = 0;
+    for (int i = 0; i < 3; i++) {
+        struct stat st;
+        if (stat(checks[i].path, &st) != 0) continue;
+        int merged = 0;
+        for (int j = 0; j < n; j++) {
+            if (checks[j].dev == st.st_dev) {
+                checks[j].need_kb += checks[i].need_kb;
+                checks[j].need_inodes += checks[i].need_inodes;
+                merged = 1;
+                break;
+            }
+        }
+        if (merged) continue;
+        checks[n] = checks[i];
+        checks[n].dev = st.st_dev;
+        n++;
+    }
+
+    char estimate[32];
+    footprint_format_size(fp->build_kb, estimate, sizeof(estimate));
+    printf(_("Estimated build footprint: %s, %llu inodes (%d modules%s, %s)"),
+           estimate, fp->build_inodes, fp->modules, fp->debug ? _(", debug info") : "", fp->format);
+    if (fp->model_kb && fp->build_kb != fp->model_kb) {
+        printf(_(", corrected x%.2f from previous builds"), (double)fp->build_kb / fp->model_kb);
+    }
+    printf("\n");
+
+    char problems[1024] = "";
+    size_t len = 0;
+    int short_space = 0;
+    for (int i = 0; i < n; i++) {
+        struct statvfs vfs;
+        if (statvfs(checks[i].path, &vfs) != 0) continue;
+
+        unsigned long long avail_kb = (unsigned long long)vfs.f_bavail * vfs.f_frsize / 1024;
+        char need[32], avail[32];
+        footprint_format_size(checks[i].need_kb, need, sizeof(need));
+        footprint_format_size(avail_kb, avail, sizeof(avail));
+
+        // Con un 25% de margen para el error de la estimación solo avisamos
+        const char *verdict = NULL;
+        if (checks[i].need_kb > avail_kb) {
+            verdict = _("not enough space");
+            short_space = 1;
+        } else if (checks[i].need_kb + checks[i].need_kb / 4 > avail_kb) {
+            verdict = _("little margin");
+        }
+        if (verdict && len < sizeof(problems)) {
+            len += snprintf(problems + len, sizeof(problems) - len, _("%s: needs %s, %s free (%s)\n"),
+                            checks[i].path, need, avail, verdict);
+        }
+
+        // btrfs y otros no tienen inodos fijos y devuelven f_files = 0
+        if (vfs.f_files == 0) continue;
+        if (checks[i].need_inodes > vfs.f_favail) {
+            short_space = 1;
+            if (len < sizeof(problems)) {
+                len += snprintf(problems + len, sizeof(problems) - len,
+                                _("%s: needs %llu inodes, %llu free (not enough inodes)\n"),
+                                checks[i].path, checks[i].need_inodes, (unsigned long long)vfs.f_favail);
+            }
+        }
+    }
+
+    if (!problems[0]) return;
+    fflush(stdout);
+    fputs(problems, stderr);
+    if (!short_space) {
+        event_message("status", _("Disk space is tight for this build"));
+        return;
+    }
+
+    if (build_opts.skip_space_check) {
+        fprintf(stderr, _("Continuing anyway (--skip-space-check).\n"));
+        return;
+    }
+    if (!build_opts.headless) {
+        char text[1400];
+        snprintf(text, sizeof(text), "%s\n\n%s\n%s", _("The build will probably run out of disk space:"),
+                 problems, _("Do you want to start it anyway?"));
+        if (dialog_yesno(_("Not Enough Disk Space"), text, 70) == 0) return;
+    }
+    fprintf(stderr, _("Free some space or use --skip-space-check, the build was not started.\n"));
+    event_message("error", _("Not enough disk space for the build"));
+    exit(EXIT_FAILURE);
+}
+
+static int footprint_used(const char *path, unsigned long long *kb, unsigned long long *inodes) {
+    struct statvfs vfs;
+    if (statvfs(path, &vfs) != 0) return -1;
+    *kb = (unsigned long long)(vfs.f_blocks - vfs.f_bfree) * vfs.f_frsize / 1024;
+    *inodes = (unsigned long long)(vfs.f_files - vfs.f_ffree);
+    return 0;
+}
+
+// Empieza a medir el uso de disco de la compilación
+void footprint_begin(const char *build_dir) {
+    memset(&footprint_usage, 0, sizeof(footprint_usage));
+    snprintf(footprint_usage.path, sizeof(footprint_usage.path), "%s", build_dir);
+    if (footprint_used(build_dir, &footprint_usage.start_kb, &footprint_usage.start_inodes) != 0) return;
+    footprint_usage.peak_kb = footprint_usage.start_kb;
+    footprint_usage.peak_inodes = footprint_usage.start_inodes;
+    footprint_usage.active = 1;
+}
+
+// Se llama con cada línea de make; statvfs es barato, pero con una vez por segundo alcanza
+void footprint_sample() {
+    if (!footprint_usage.active) return;
+    time_t now = time(NULL);
+    if (now == footprint_usage.last_sample) return;
+    footprint_usage.last_sample = now;
+
+    unsigned long long kb, inodes;
+    if (footprint_used(footprint_usage.path, &kb, &inodes) != 0) return;
+    if (kb > footprint_usage.peak_kb) footprint_usage.peak_kb = kb;
+    if (inodes > footprint_usage.peak_inodes) footprint_usage.peak_inodes = inodes;
+}
+
+// Registra el pico real junto al modelo sin corregir, para la próxima estimación
+void footprint_finish(const char *home, const char *versions, const Footprint *fp) {
+    if (!footprint_usage.active) return;
+    footprint_usage.last_sample = 0;
+    footprint_sample();
+    footprint_usage.active = 0;
+
+    unsigned long long peak_kb = footprint_usage.peak_kb - footprint_usage.start_kb;
+    unsigned long long peak_inodes = footprint_usage.peak_inodes - footprint_usage.start_inodes;
+
+    char peak[32], estimate[32];
+    footprint_format_size(peak_kb, peak, sizeof(peak));
+    footprint_format_size(fp->build_kb, estimate, sizeof(estimate));
+    printf(_("Disk used by the build: %s at its peak (estimated %s)\n"), peak, estimate);
+
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    FILE *log = fopen(log_path, "a");
+    if (!log) return;
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(log, "%s footprint=%s format=%s debug=%d model_kb=%llu peak_kb=%llu "
+                 "model_inodes=%llu peak_inodes=%llu modules=%d\n",
+            stamp, versions, fp->format, fp->debug, fp->model_kb, peak_kb,
+            fp->model_inodes, peak_inodes, fp->modules);
+    fclose(log);
+}
+
+#endif
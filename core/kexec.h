@@ -0,0 +1,162 @@
+// Reinicio rápido con kexec al kernel recién instalado.
+
+#ifndef KEXEC_H
+#define KEXEC_H
+
+#include <time.h>
+#include <sys/utsname.h>
+
+#include "../distro/common.h"
+
+#define KEXEC_PENDING_FILE "kexec-pending"
+
+double realtime_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Devuelve NULL si se puede usar kexec, o el motivo por el que no
+const char* kexec_unavailable_reason() {
+    if (system("command -v kexec > /dev/null 2>&1") != 0) {
+        return _("kexec-tools is not installed");
+    }
+
+    char buf[128] = "";
+    FILE *fp = fopen("/proc/sys/kernel/kexec_load_disabled", "r");
+    if (fp) {
+        if (fgets(buf, sizeof(buf), fp) && atoi(buf) == 1) {
+            fclose(fp);
+            return _("kexec is disabled (kernel.kexec_load_disabled=1)");
+        }
+        fclose(fp);
+    }
+
+    // Con lockdown (Secure Boot) solo se aceptan kernels firmados por una clave de confianza
+    fp = fopen("/sys/kernel/security/lockdown", "r");
+    if (fp) {
+        if (fgets(buf, sizeof(buf), fp) && !strstr(buf, "[none]")) {
+            fclose(fp);
+            return _("kernel lockdown (Secure Boot) forbids loading an unsigned kernel");
+        }
+        fclose(fp);
+    }
+
+    // Un enrolamiento MOK pendiente solo se completa pasando por el firmware
+    if (system("command -v mokutil > /dev/null 2>&1") == 0 &&
+        system("mokutil --list-new 2>/dev/null | grep -qi certificate") == 0) {
+        return _("a pending Secure Boot key enrollment needs a firmware reboot");
+    }
+
+    return NULL;
+}
+
+void normal_reboot() {
+    printf(_("Rebooting system...\n"));
+    if (system("sudo reboot") != 0) {
+        fprintf(stderr, _("Reboot failed. Please reboot manually.\n"));
+    }
+}
+
+// Carga el kernel nuevo y reinicia a través de él. Si algo falla, reinicio normal.
+void kexec_fast_reboot(DistroOperations *ops, const char *kernel_version) {
+    const char *reason = kexec_unavailable_reason();
+    if (reason) {
+        printf(_("Fast reboot not possible: %s. Falling back to a normal reboot.\n"), reason);
+        normal_reboot();
+        return;
+    }
+
+    char initrd[512] = "";
+    if (ops && ops->get_initramfs_path) {
+        ops->get_initramfs_path(kernel_version, initrd, sizeof(initrd));
+    }
+
+    char cmd[1536];
+    struct stat st;
+    if (initrd[0] && stat(initrd, &st) == 0) {
+        snprintf(cmd, sizeof(cmd), "sudo kexec -l /boot/vmlinuz-%s --initrd=%s --reuse-cmdline",
+                 kernel_version, initrd);
+    } else {
+        snprintf(cmd, sizeof(cmd), "sudo kexec -l /boot/vmlinuz-%s --reuse-cmdline", kernel_version);
+    }
+
+    double start = realtime_now();
+    printf("\n %s: %s\n", _("Running"), cmd);
+    if (system(cmd) != 0) {
+        printf(_("kexec could not load the new kernel. Falling back to a normal reboot.\n"));
+        normal_reboot();
+        return;
+    }
+    double load_seconds = realtime_now() - start;
+    printf(_("New kernel loaded in %.1f s.\n"), load_seconds);
+
+    // Guardamos el momento del salto; al volver a ejecutar el programa con el kernel
+    // nuevo se calcula cuánto tardó el traspaso (ver kexec_report_handoff)
+    const char *home = getenv("HOME");
+    char path[512] = "";
+    if (home) {
+        snprintf(path, sizeof(path), "%s/kernel_build/" KEXEC_PENDING_FILE, home);
+        FILE *fp = fopen(path, "w");
+        if (fp) {
+            fprintf(fp, "%s %.3f %.3f\n", kernel_version, start, load_seconds);
+            fclose(fp);
+        }
+    }
+
+    printf(_("Rebooting into %s with kexec...\n"), kernel_version);
+    // systemctl kexec apaga los servicios de forma ordenada antes de saltar
+    if (system("sudo systemctl kexec") != 0) {
+        printf(_("systemctl kexec failed. Falling back to a normal reboot.\n"));
+        // Un reinicio normal no es un traspaso por kexec: no hay nada que medir
+        if (path[0]) unlink(path);
+        normal_reboot();
+    }
+}
+
+// Al arrancar: si el último reinicio fue por kexec, informar cuánto tardó el traspaso
+void kexec_report_handoff(const char *home) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/kernel_build/" KEXEC_PENDING_FILE, home);
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+
+    char kernel_version[128];
+    double start, load_seconds;
+    int ok = (fscanf(fp, "%127s %lf %lf", kernel_version, &start, &load_seconds) == 3);
+    fclose(fp);
+    unlink(path);
+    if (!ok) return;
+
+    // Si no arrancó el kernel cargado, el reinicio no fue por kexec
+    struct utsname uts;
+    if (uname(&uts) != 0 || strcmp(uts.release, kernel_version) != 0) return;
+
+    double uptime = 0;
+    fp = fopen("/proc/uptime", "r");
+    if (fp) {
+        if (fscanf(fp, "%lf", &uptime) != 1) uptime = 0;
+        fclose(fp);
+    }
+
+    double boot_time = realtime_now() - uptime;
+    double handoff = boot_time - start;
+    if (uptime <= 0 || handoff < 0) return;
+
+    printf(_("Last fast reboot into %s: kernel load %.1f s, shutdown and kexec handoff %.1f s.\n"),
+           kernel_version, load_seconds, handoff - load_seconds);
+
+    snprintf(path, sizeof(path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    fp = fopen(path, "a");
+    if (!fp) return;
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "%s kexec=%s load_seconds=%.1f handoff_seconds=%.1f\n",
+            stamp, kernel_version, load_seconds, handoff - load_seconds);
+    fclose(fp);
+}
+
+#endif
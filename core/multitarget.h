@@ -0,0 +1,492 @@
+// --targets: varias versiones compiladas a la vez, con las CPUs repartidas.
+
+#ifndef MULTITARGET_H
+#define MULTITARGET_H
+
+#include <sched.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+#include <ncurses.h>
+
+#include "../distro/common.h"
+#include "bootopt.h"
+#include "background.h"
+#include "events.h"
+#include "footprint.h"
+
+#define MAX_TARGETS 4
+
+typedef struct {
+    char label[16];         // stable, longterm o pinned
+    char version[32];
+    char tag[64];
+    char source_dir[512];
+    char cpu_list[128];
+    int jobs;
+    pid_t pid;
+    int fd;
+    FILE *log;              // copia completa de la salida en ~/kernel_build/build-<versión>.log
+    int total_files;
+    int count;
+    int last_percent;       // último porcentaje publicado como evento
+    int status;             // -1 compilando, 0 listo, >0 falló
+    int already_built;
+    char partial[1024];     // línea a medio leer del pipe
+    size_t partial_len;
+} BuildTarget;
+
+// Convierte "stable,longterm,6.6.60" en targets con versión y tag propios
+int resolve_targets(const char *spec, BuildTarget *targets, int max) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    int n = 0;
+    char *saveptr = NULL;
+    for (char *item = strtok_r(buf, ",", &saveptr); item; item = strtok_r(NULL, ",", &saveptr)) {
+        if (n == max) {
+            fprintf(stderr, _("Too many targets, at most %d are supported.\n"), max);
+            return -1;
+        }
+        BuildTarget *t = &targets[n];
+        memset(t, 0, sizeof(*t));
+        t->fd = -1;
+        t->status = -1;
+        t->last_percent = -1;
+
+        if (strcmp(item, "stable") == 0 || strcmp(item, "longterm") == 0 || strcmp(item, "lts") == 0) {
+            const char *moniker = (strcmp(item, "stable") == 0) ? "stable" : "longterm";
+            snprintf(t->label, sizeof(t->label), "%s", moniker);
+            if (fetch_kernel_version(moniker, t->version, sizeof(t->version)) != 0) {
+                fprintf(stderr, _("Could not fetch the %s kernel version.\n"), moniker);
+                return -1;
+            }
+        } else if (strspn(item, "0123456789.") == strlen(item) && strchr(item, '.')) {
+            snprintf(t->label, sizeof(t->label), "pinned");
+            snprintf(t->version, sizeof(t->version), "%s", item);
+        } else {
+            fprintf(stderr, _("Unknown target: %s\n"), item);
+            return -1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (strcmp(targets[i].version, t->version) == 0) {
+                fprintf(stderr, _("Kernel %s was requested twice.\n"), t->version);
+                return -1;
+            }
+        }
+
+        snprintf(t->tag, sizeof(t->tag), "-lexi-%s-amd64", t->label);
+        printf(_("Target %s: kernel %s\n"), t->label, t->version);
+        n++;
+    }
+    return n;
+}
+
+// "0,1,2,3,8" -> "0-3,8"
+void format_cpu_list(const int *cpus, int n, char *out, size_t size) {
+    size_t len = 0;
+    out[0] = '\0';
+    for (int i = 0; i < n && len < size; ) {
+        int j = i;
+        while (j + 1 < n && cpus[j + 1] == cpus[j] + 1) j++;
+        if (j > i) {
+            len += snprintf(out + len, size - len, "%s%d-%d", len ? "," : "", cpus[i], cpus[j]);
+        } else {
+            len += snprintf(out + len, size - len, "%s%d", len ? "," : "", cpus[i]);
+        }
+        i = j + 1;
+    }
+}
+
+// Reparte las CPUs permitidas en bloques contiguos, uno por target a compilar
+void partition_cpus(BuildTarget *targets, int n) {
+    cpu_set_t set;
+    int cpus[CPU_SETSIZE];
+    int ncpus = 0;
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &set)) cpus[ncpus++] = i;
+        }
+    }
+    if (ncpus == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int i = 0; i < online && i < CPU_SETSIZE; i++) cpus[ncpus++] = i;
+    }
+
+    int building = 0;
+    for (int i = 0; i < n; i++) {
+        if (!targets[i].already_built) building++;
+    }
+    if (building == 0) return;
+
+    int pin = (system("command -v taskset > /dev/null 2>&1") == 0);
+    int share = ncpus / building;
+    int extra = ncpus % building;
+    int next = 0;
+
+    for (int i = 0; i < n; i++) {
+        BuildTarget *t = &targets[i];
+        if (t->already_built) continue;
+
+        if (share == 0) {
+            // Más targets que CPUs: compartimos una CPU por target
+            t->jobs = 1;
+            format_cpu_list(&cpus[next++ % ncpus], 1, t->cpu_list, sizeof(t->cpu_list));
+        } else {
+            t->jobs = share + (extra-- > 0 ? 1 : 0);
+            format_cpu_list(&cpus[next], t->jobs, t->cpu_list, sizeof(t->cpu_list));
+            next += t->jobs;
+        }
+        if (!pin) t->cpu_list[0] = '\0';
+    }
+}
+
+// Cada compilación corre en un proceso hijo con su salida conectada a un pipe
+void start_target_build(BuildTarget *targets, int index, const char *home, DistroOperations *ops) {
+    BuildTarget *t = &targets[index];
+    int fds[2];
+
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pid == 0) {
+        events_detach();
+        for (int i = 0; i < index; i++) {
+            if (targets[i].fd >= 0) close(targets[i].fd);
+        }
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[1]);
+
+        int devnull = open("/dev/null", O_RDONLY);
+        if (devnull >= 0) {
+            dup2(devnull, STDIN_FILENO);
+            close(devnull);
+        }
+        setvbuf(stdout, NULL, _IOLBF, 0);
+
+        build_opts.jobs = t->jobs;
+        build_opts.cpu_list = t->cpu_list[0] ? t->cpu_list : NULL;
+        build_opts.plain_progress = 1;
+
+        ops->build_packages(home, t->version, t->tag);
+        fflush(stdout);
+        _exit(0);
+    }
+
+    close(fds[1]);
+
+    char log_path[1024];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/build-%s.log", home, t->version);
+    t->log = fopen(log_path, "w");
+
+    t->pid = pid;
+    t->fd = fds[0];
+    t->total_files = count_source_files(t->source_dir);
+    if (t->total_files == 0) t->total_files = 1;
+}
+
+void draw_target_bar(WINDOW *win, int row, BuildTarget *t, int width) {
+    int percent = (t->count * 100) / t->total_files;
+    if (percent > 100 || t->status == 0) percent = 100;
+
+    const char *state;
+    if (t->already_built) state = _("already built");
+    else if (t->status < 0) state = _("building");
+    else if (t->status == 0) state = _("done");
+    else state = _("FAILED");
+
+    wmove(win, row, 0);
+    wclrtoeol(win);
+    wprintw(win, "%-9s %-10s cpu %-9s [", t->label, t->version,
+            t->cpu_list[0] ? t->cpu_list : "all");
+
+    int bar_width = width - 60;
+    if (bar_width < 10) bar_width = 10;
+    int filled_width = (percent * bar_width) / 100;
+
+    if (has_colors()) wattron(win, COLOR_PAIR(1));
+    for (int i = 0; i < bar_width; i++) {
+        if (i < filled_width) waddch(win, '=');
+        else if (i == filled_width) waddch(win, '>');
+        else waddch(win, ' ');
+    }
+    if (has_colors()) wattroff(win, COLOR_PAIR(1));
+    wprintw(win, "] %3d%% %s", percent, state);
+}
+
+// Pantalla combinada: una barra por target y el log intercalado debajo
+void draw_multi_screen(BuildTarget *targets, int n, WINDOW **log_win) {
+    int height, width;
+    getmaxyx(stdscr, height, width);
+
+    erase();
+    char header_text[256];
+    char limits[160];
+    background_describe(limits, sizeof(limits));
+    snprintf(header_text, sizeof(header_text), "Alexia Kernel Installer - %d %s%s%s", n, _("kernels"),
+             limits[0] ? " - " : "", limits);
+    int header_x = (width - (int)strlen(header_text)) / 2;
+    if (header_x < 0) header_x = 0;
+
+    if (has_colors()) attron(COLOR_PAIR(2) | A_BOLD);
+    mvprintw(0, header_x, "%s", header_text);
+    if (has_colors()) attroff(COLOR_PAIR(2) | A_BOLD);
+
+    mvhline(1, 0, ACS_HLINE, width);
+    for (int i = 0; i < n; i++) {
+        draw_target_bar(stdscr, 2 + i, &targets[i], width);
+    }
+    mvhline(2 + n, 0, ACS_HLINE, width);
+    refresh();
+
+    int log_height = height - (3 + n);
+    if (log_height < 3) log_height = 3;
+    if (*log_win) delwin(*log_win);
+    *log_win = newwin(log_height, width, 3 + n, 0);
+    scrollok(*log_win, TRUE);
+    wrefresh(*log_win);
+}
+
+// log_win es NULL en modo --headless: la salida va a stderr
+void handle_target_line(BuildTarget *t, const char *line, WINDOW *log_win) {
+    if (log_win) wprintw(log_win, "[%s] %s\n", t->label, line);
+    else fprintf(stderr, "[%s] %s\n", t->label, line);
+    if (t->log) fprintf(t->log, "%s\n", line);
+    if (is_compile_line(line)) {
+        t->count++;
+    }
+    event_build_line(t->label, line, t->count, t->total_files, &t->last_percent);
+    footprint_sample();
+}
+
+void read_target_output(BuildTarget *t, WINDOW *log_win) {
+    char buf[4096];
+    ssize_t r = read(t->fd, buf, sizeof(buf));
+
+    if (r <= 0) {
+        if (r < 0 && errno == EINTR) return;
+        close(t->fd);
+        t->fd = -1;
+        if (t->log) {
+            fclose(t->log);
+            t->log = NULL;
+        }
+
+        int status;
+        waitpid(t->pid, &status, 0);
+        t->status = (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+
+        char message[128];
+        snprintf(message, sizeof(message), "%s %s %s", t->label, t->version,
+                 t->status == 0 ? "built" : "failed");
+        event_message(t->status == 0 ? "status" : "error", message);
+        return;
+    }
+
+    for (ssize_t i = 0; i < r; i++) {
+        if (buf[i] == '\n' || t->partial_len == sizeof(t->partial) - 1) {
+            t->partial[t->partial_len] = '\0';
+            handle_target_line(t, t->partial, log_win);
+            t->partial_len = 0;
+        } else {
+            t->partial[t->partial_len++] = buf[i];
+        }
+    }
+}
+
+// Sin pantalla: solo se leen los pipes, el progreso sale como eventos
+void run_targets_headless(BuildTarget *targets, int n) {
+    while (1) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        int maxfd = -1;
+        for (int i = 0; i < n; i++) {
+            if (targets[i].fd >= 0) {
+                FD_SET(targets[i].fd, &readfds);
+                if (targets[i].fd > maxfd) maxfd = targets[i].fd;
+            }
+        }
+        if (maxfd < 0) break;
+
+        if (select(maxfd + 1, &readfds, NULL, NULL, NULL) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            if (targets[i].fd >= 0 && FD_ISSET(targets[i].fd, &readfds)) {
+                read_target_output(&targets[i], NULL);
+            }
+        }
+    }
+}
+
+void run_targets_with_progress(BuildTarget *targets, int n) {
+    if (build_opts.headless) {
+        run_targets_headless(targets, n);
+        return;
+    }
+
+    initscr();
+    cbreak();
+    noecho();
+    curs_set(0);
+
+    if (has_colors()) {
+        start_color();
+        init_pair(1, COLOR_GREEN, COLOR_BLACK);
+        init_pair(2, COLOR_CYAN, COLOR_BLACK);
+    }
+
+    WINDOW *log_win = NULL;
+    draw_multi_screen(targets, n, &log_win);
+
+    // Con --background, +/- cambian los límites de todas las compilaciones a la vez
+    int watch_keys = build_opts.background && isatty(STDIN_FILENO);
+    if (watch_keys) nodelay(stdscr, TRUE);
+
+    while (1) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        int maxfd = -1;
+        for (int i = 0; i < n; i++) {
+            if (targets[i].fd >= 0) {
+                FD_SET(targets[i].fd, &readfds);
+                if (targets[i].fd > maxfd) maxfd = targets[i].fd;
+            }
+        }
+        if (maxfd < 0) break;
+        if (watch_keys) FD_SET(STDIN_FILENO, &readfds);
+
+        if (select(maxfd + 1, &readfds, NULL, NULL, NULL) < 0) {
+            if (errno == EINTR) {
+                // SIGWINCH: redibujamos todo con el nuevo tamaño
+                endwin();
+                refresh();
+                draw_multi_screen(targets, n, &log_win);
+                continue;
+            }
+            break;
+        }
+
+        if (watch_keys && FD_ISSET(STDIN_FILENO, &readfds)) {
+            int ch, changed = 0;
+            while ((ch = getch()) != ERR) changed |= background_handle_key(ch);
+            if (changed) draw_multi_screen(targets, n, &log_win);
+        }
+
+        int width = getmaxx(stdscr);
+        for (int i = 0; i < n; i++) {
+            if (targets[i].fd >= 0 && FD_ISSET(targets[i].fd, &readfds)) {
+                read_target_output(&targets[i], log_win);
+                draw_target_bar(stdscr, 2 + i, &targets[i], width);
+            }
+        }
+        refresh();
+        wrefresh(log_win);
+    }
+
+    if (log_win) delwin(log_win);
+    endwin();
+}
+
+// Descarga, configura y compila todos los targets; luego instala los que salieron bien.
+// Devuelve en installed la lista de versiones instaladas para el diálogo final.
+void run_multi_target(const char *home, DistroOperations *ops, Distro distro,
+                      char *installed, size_t installed_size) {
+    BuildTarget targets[MAX_TARGETS];
+    int n = resolve_targets(build_opts.targets, targets, MAX_TARGETS);
+    if (n <= 0) exit(EXIT_FAILURE);
+
+    // La descarga y la configuración son rápidas: se hacen de a una
+    for (int i = 0; i < n; i++) {
+        BuildTarget *t = &targets[i];
+        // Copia local: version y source_dir están en el mismo objeto (-Wrestrict)
+        char version[sizeof(t->version)];
+        snprintf(version, sizeof(version), "%s", t->version);
+        snprintf(t->source_dir, sizeof(t->source_dir), "%s/kernel_build/linux-%s", home, version);
+
+        if (are_packages_built(home, t->version, t->tag, distro)) {
+            printf(_("Packages for %s%s already exist, skipping its build.\n"), t->version, t->tag);
+            t->already_built = 1;
+            t->status = 0;
+            continue;
+        }
+
+        fetch_kernel_source(home, t->version);
+        configure_kernel_tree(home, t->version, t->tag);
+    }
+
+    // Se compilan todas a la vez: el espacio tiene que alcanzar para la suma
+    char build_dir[512];
+    char versions[256] = "";
+    size_t versions_len = 0;
+    Footprint total = { 0 };
+    snprintf(build_dir, sizeof(build_dir), "%s/kernel_build", home);
+    for (int i = 0; i < n; i++) {
+        if (targets[i].already_built) continue;
+        Footprint fp;
+        footprint_estimate(home, targets[i].version, targets[i].source_dir, footprint_format(distro), &fp);
+        footprint_add(&total, &fp);
+        if (versions_len < sizeof(versions)) {
+            versions_len += snprintf(versions + versions_len, sizeof(versions) - versions_len, "%s%s",
+                                     versions_len ? "," : "", targets[i].version);
+        }
+    }
+    if (versions_len) footprint_preflight(build_dir, &total);
+
+    partition_cpus(targets, n);
+    footprint_begin(build_dir);
+    for (int i = 0; i < n; i++) {
+        if (!targets[i].already_built) {
+            start_target_build(targets, i, home, ops);
+        }
+    }
+    run_targets_with_progress(targets, n);
+    if (versions_len) footprint_finish(home, versions, &total);
+
+    size_t len = 0;
+    installed[0] = '\0';
+    int failed = 0;
+    for (int i = 0; i < n; i++) {
+        BuildTarget *t = &targets[i];
+        if (t->status != 0) {
+            fprintf(stderr, _("Build of %s (%s) failed, see %s/kernel_build/build-%s.log\n"),
+                    t->version, t->label, home, t->version);
+            failed++;
+            continue;
+        }
+        printf(_("Installing kernel packages for %s%s...\n"), t->version, t->tag);
+        char kernel_version[128];
+        snprintf(kernel_version, sizeof(kernel_version), "%s%s", t->version, t->tag);
+        bootopt_begin_install(ops);
+        ops->install_packages(home, t->version, t->tag);
+        bootopt_finish_install(ops, kernel_version);
+
+        if (len < installed_size) {
+            len += snprintf(installed + len, installed_size - len, "%s%s%s",
+                            len ? ", " : "", t->version, t->tag);
+        }
+    }
+
+    if (failed == n) {
+        fprintf(stderr, _("No kernel could be built.\n"));
+        exit(EXIT_FAILURE);
+    }
+}
+
+#endif
@@ -0,0 +1,409 @@
+// Microbenchmarks del kernel antes de instalar y en el primer arranque del nuevo.
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+#include "../distro/common.h"
+#include "events.h"
+
+#define PERF_DIR_NAME     "perf"
+#define PERF_PENDING_FILE "pending"
+#define PERF_ROUNDS       3
+// Antes de medir se espera (hasta 30 s) a que la CPU quede por debajo de este uso
+#define PERF_SETTLE_BUSY_PERCENT 10
+#define PERF_SETTLE_MAX_SECONDS  30
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    int higher_is_better;
+    double threshold;           // % de empeoramiento tolerado
+    double (*run)(void);
+} PerfBench;
+
+static double perf_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Ida y vuelta al kernel: syscall() directo para que glibc no lo resuelva en espacio de usuario
+static double perf_syscall() {
+    const long n = 1000000;
+    double start = perf_now_ns();
+    for (long i = 0; i < n; i++) syscall(SYS_getppid);
+    return (perf_now_ns() - start) / n;
+}
+
+// Dos procesos en la misma CPU pasándose un byte por pipes: cada vuelta son dos cambios de contexto
+static double perf_context_switch() {
+    const long n = 50000;
+    int ping[2], pong[2];
+    if (pipe(ping) != 0) return -1;
+    if (pipe(pong) != 0) {
+        close(ping[0]);
+        close(ping[1]);
+        return -1;
+    }
+
+    cpu_set_t saved, one;
+    int pinned = (sched_getaffinity(0, sizeof(saved), &saved) == 0);
+    if (pinned) {
+        CPU_ZERO(&one);
+        CPU_SET(sched_getcpu(), &one);
+        sched_setaffinity(0, sizeof(one), &one);
+    }
+
+    char c = 0;
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (long i = 0; i < n; i++) {
+            if (read(ping[0], &c, 1) != 1 || write(pong[1], &c, 1) != 1) _exit(1);
+        }
+        _exit(0);
+    }
+
+    double start = perf_now_ns();
+    for (long i = 0; pid > 0 && i < n; i++) {
+        if (write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1) break;
+    }
+    double elapsed = perf_now_ns() - start;
+
+    if (pid > 0) waitpid(pid, NULL, 0);
+    if (pinned) sched_setaffinity(0, sizeof(saved), &saved);
+    close(ping[0]);
+    close(ping[1]);
+    close(pong[0]);
+    close(pong[1]);
+    return (pid > 0) ? elapsed / (2.0 * n) : -1;
+}
+
+// MB/s escribiendo 256 MiB de a 64 KiB hacia un hijo que solo lee
+static double perf_stream(int fds[2]) {
+    const size_t chunk = 64 * 1024;
+    const size_t total = 256UL * 1024 * 1024;
+    static char buf[64 * 1024];
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[1]);
+        while (read(fds[0], buf, chunk) > 0) {}
+        _exit(0);
+    }
+    close(fds[0]);
+    if (pid < 0) {
+        close(fds[1]);
+        return -1;
+    }
+
+    double start = perf_now_ns();
+    size_t sent = 0;
+    while (sent < total) {
+        ssize_t w = write(fds[1], buf, chunk);
+        if (w <= 0) break;
+        sent += w;
+    }
+    close(fds[1]);
+    waitpid(pid, NULL, 0);
+    double seconds = (perf_now_ns() - start) / 1e9;
+    return (sent == total && seconds > 0) ? sent / (1024.0 * 1024.0) / seconds : -1;
+}
+
+static double perf_pipe() {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    return perf_stream(fds);
+}
+
+static double perf_socket() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return -1;
+    return perf_stream(fds);
+}
+
+// Costo de un fallo de página anónima: se toca un byte por página en 256 MiB nuevos
+static double perf_page_fault() {
+    const size_t size = 256UL * 1024 * 1024;
+    long page = sysconf(_SC_PAGESIZE);
+    char *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return -1;
+    madvise(mem, size, MADV_NOHUGEPAGE);  // con páginas enormes casi no habría fallos
+
+    double start = perf_now_ns();
+    for (size_t off = 0; off < size; off += page) mem[off] = 1;
+    double elapsed = perf_now_ns() - start;
+
+    munmap(mem, size);
+    return elapsed / (size / page);
+}
+
+// fork + exec de /bin/true + waitpid, en microsegundos
+static double perf_fork_exec() {
+    const int n = 500;
+    double start = perf_now_ns();
+    for (int i = 0; i < n; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            execl("/bin/true", "true", (char *)NULL);
+            _exit(127);
+        }
+        if (pid < 0) return -1;
+        waitpid(pid, NULL, 0);
+    }
+    return (perf_now_ns() - start) / n / 1000.0;
+}
+
+static const PerfBench perf_benches[] = {
+    { "syscall",        "ns",   0, 10.0, perf_syscall },
+    { "context_switch", "ns",   0, 15.0, perf_context_switch },
+    { "pipe",           "MB/s", 1, 10.0, perf_pipe },
+    { "socket",         "MB/s", 1, 10.0, perf_socket },
+    { "page_fault",     "ns",   0, 10.0, perf_page_fault },
+    { "fork_exec",      "us",   0, 15.0, perf_fork_exec },
+};
+
+#define PERF_BENCH_COUNT ((int)(sizeof(perf_benches) / sizeof(perf_benches[0])))
+
+static void perf_dir(const char *home, char *out, size_t size) {
+    char fallback[512];
+    snprintf(fallback, sizeof(fallback), "%s/kernel_build/" PERF_DIR_NAME, home);
+    snprintf(out, size, "%s", env_or_default("KERNEL_INSTALLER_PERF_DIR", fallback));
+}
+
+static const char* perf_running_release() {
+    static struct utsname uts;
+    if (uname(&uts) != 0) return "unknown";
+    return uts.release;
+}
+
+// Tiempo total y ocioso (idle + iowait) de todas las CPUs según /proc/stat
+static int perf_cpu_times(unsigned long long *total, unsigned long long *idle) {
+    FILE *fp = fopen("/proc/stat", "r");
+    if (!fp) return -1;
+    unsigned long long v[8] = { 0 };
+    int n = fscanf(fp, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]);
+    fclose(fp);
+    if (n < 5) return -1;
+
+    *total = 0;
+    for (int i = 0; i < 8; i++) *total += v[i];
+    *idle = v[3] + v[4];
+    return 0;
+}
+
+// Recién terminada la compilación quedan escrituras pendientes y procesos cerrando:
+// medir en ese momento falsea la línea base
+static void perf_settle() {
+    sync();
+    for (int i = 0; i < PERF_SETTLE_MAX_SECONDS * 2; i++) {
+        unsigned long long total1, idle1, total2, idle2;
+        if (perf_cpu_times(&total1, &idle1) != 0) return;
+        usleep(500000);
+        if (perf_cpu_times(&total2, &idle2) != 0 || total2 <= total1) return;
+
+        double busy = 100.0 * (double)((total2 - total1) - (idle2 - idle1)) / (double)(total2 - total1);
+        if (busy < PERF_SETTLE_BUSY_PERCENT) return;
+    }
+    printf(_("The system is still busy, measuring anyway.\n"));
+}
+
+// Cada benchmark se corre PERF_ROUNDS veces y se queda el mejor valor (menos ruido)
+static void perf_run_suite(double *results) {
+    perf_settle();
+    printf(_("Running kernel microbenchmarks on %s...\n"), perf_running_release());
+    for (int i = 0; i < PERF_BENCH_COUNT; i++) {
+        const PerfBench *b = &perf_benches[i];
+        double best = -1;
+        for (int round = 0; round < PERF_ROUNDS; round++) {
+            double value = b->run();
+            if (value < 0) continue;
+            if (best < 0 || (b->higher_is_better ? value > best : value < best)) best = value;
+        }
+        results[i] = best;
+        printf("  %-15s %12.1f %s\n", b->name, best, b->unit);
+    }
+}
+
+static int perf_save(const char *path, const double *results) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "date=%s\n", stamp);
+    fprintf(fp, "kernel=%s\n", perf_running_release());
+    for (int i = 0; i < PERF_BENCH_COUNT; i++) {
+        fprintf(fp, "%s=%.3f\n", perf_benches[i].name, results[i]);
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int perf_load(const char *path, double *results) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    for (int i = 0; i < PERF_BENCH_COUNT; i++) results[i] = -1;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char name[64];
+        double value;
+        if (sscanf(line, "%63[^=]=%lf", name, &value) != 2) continue;
+        for (int i = 0; i < PERF_BENCH_COUNT; i++) {
+            if (strcmp(name, perf_benches[i].name) == 0) results[i] = value;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+// Antes de instalar: línea base del kernel en uso y aviso para el primer arranque del nuevo
+void perf_record_baseline(const char *home, const char *new_kernel) {
+    const char *release = perf_running_release();
+    if (strcmp(release, new_kernel) == 0) return;  // reinstalación del mismo kernel
+
+    char dir[512];
+    perf_dir(home, dir, sizeof(dir));
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        perror(dir);
+        return;
+    }
+
+    double results[PERF_BENCH_COUNT];
+    perf_run_suite(results);
+
+    char path[768];
+    snprintf(path, sizeof(path), "%s/%s", dir, release);
+    if (perf_save(path, results) != 0) return;
+
+    snprintf(path, sizeof(path), "%s/" PERF_PENDING_FILE, dir);
+    FILE *fp = fopen(path, "w");
+    if (!fp) return;
+    fprintf(fp, "baseline=%s\nexpected=%s\n", release, new_kernel);
+    fclose(fp);
+
+    printf(_("Performance baseline saved. After rebooting into %s run kernel-installer --perf-check "
+             "to compare.\n"), new_kernel);
+}
+
+// Compara y muestra la tabla. Devuelve cuántos benchmarks superaron su umbral.
+static int perf_compare(const double *baseline, const double *current, char *failed, size_t failed_size) {
+    int failures = 0;
+    size_t len = 0;
+    failed[0] = '\0';
+
+    printf("\n========================================\n");
+    printf("  %-15s %12s %12s %8s\n", _("benchmark"), _("baseline"), _("new"), _("delta"));
+    for (int i = 0; i < PERF_BENCH_COUNT; i++) {
+        const PerfBench *b = &perf_benches[i];
+        if (baseline[i] <= 0 || current[i] <= 0) {
+            printf("  %-15s %12s\n", b->name, _("n/a"));
+            continue;
+        }
+
+        double delta = (current[i] - baseline[i]) * 100.0 / baseline[i];
+        double worse = b->higher_is_better ? -delta : delta;
+        int fail = worse > b->threshold;
+        printf("  %-15s %12.1f %12.1f %+7.1f%% %s\n", b->name, baseline[i], current[i], delta,
+               fail ? _("FAIL") : _("pass"));
+
+        if (fail) {
+            failures++;
+            if (len < failed_size) {
+                len += snprintf(failed + len, failed_size - len, "%s%s", len ? "," : "", b->name);
+            }
+        }
+    }
+    printf("========================================\n\n");
+    return failures;
+}
+
+// Al arrancar: si hay una comprobación pendiente y ya estamos en el kernel nuevo,
+// correr la suite y comparar. Devuelve 1 si hubo regresiones, 0 si no (o si no tocaba).
+int perf_check_pending(const char *home, int verbose) {
+    char dir[512];
+    perf_dir(home, dir, sizeof(dir));
+
+    char path[768];
+    snprintf(path, sizeof(path), "%s/" PERF_PENDING_FILE, dir);
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        if (verbose) printf(_("No performance check pending.\n"));
+        return 0;
+    }
+
+    char baseline_kernel[128] = "", expected[128] = "", line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        sscanf(line, "baseline=%127s", baseline_kernel);
+        sscanf(line, "expected=%127s", expected);
+    }
+    fclose(fp);
+
+    const char *release = perf_running_release();
+    if (strcmp(release, expected) != 0) {
+        if (verbose) printf(_("Performance check pending for %s, but the running kernel is %s.\n"),
+                            expected, release);
+        return 0;
+    }
+
+    double baseline[PERF_BENCH_COUNT], current[PERF_BENCH_COUNT];
+    char baseline_path[768];
+    snprintf(baseline_path, sizeof(baseline_path), "%s/%s", dir, baseline_kernel);
+    if (perf_load(baseline_path, baseline) != 0) {
+        fprintf(stderr, _("Performance baseline for %s not found, skipping the check.\n"), baseline_kernel);
+        unlink(path);
+        return 0;
+    }
+
+    printf(_("First boot into %s: comparing performance with %s.\n"), release, baseline_kernel);
+    perf_run_suite(current);
+
+    char current_path[768];
+    snprintf(current_path, sizeof(current_path), "%s/%s", dir, release);
+    perf_save(current_path, current);
+
+    char failed[256];
+    int failures = perf_compare(baseline, current, failed, sizeof(failed));
+    unlink(path);
+
+    char message[512];
+    if (failures) {
+        snprintf(message, sizeof(message), _("Performance regression in %s against %s: %s"),
+                 release, baseline_kernel, failed);
+    } else {
+        snprintf(message, sizeof(message), _("No performance regressions in %s against %s"),
+                 release, baseline_kernel);
+    }
+    printf("%s\n", message);
+    event_message(failures ? "error" : "status", message);
+
+    snprintf(path, sizeof(path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    fp = fopen(path, "a");
+    if (fp) {
+        char stamp[32];
+        time_t now = time(NULL);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+        fprintf(fp, "%s perf=%s baseline=%s result=%s", stamp, release, baseline_kernel,
+                failures ? "fail" : "pass");
+        if (failures) fprintf(fp, " failed=%s", failed);
+        fprintf(fp, "\n");
+        fclose(fp);
+    }
+    return failures ? 1 : 0;
+}
+
+#endif
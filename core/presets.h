@@ -0,0 +1,213 @@
+// Presets de configuración por carga de trabajo, mezclados con merge_config.sh.
+
+#ifndef PRESETS_H
+#define PRESETS_H
+
+#include "../distro/common.h"
+#include "profile.h"
+
+typedef struct {
+    const char* name;
+    const char* description;
+    const char* fragment;
+} KernelPreset;
+
+static KernelPreset kernel_presets[] = {
+    {"low-latency", "Full preemption, 1000 Hz, tickless CPUs, THP on madvise",
+     "CONFIG_PREEMPT=y\n"
+     "# CONFIG_PREEMPT_NONE is not set\n"
+     "# CONFIG_PREEMPT_VOLUNTARY is not set\n"
+     "CONFIG_HZ_1000=y\n"
+     "# CONFIG_HZ_250 is not set\n"
+     "CONFIG_HZ=1000\n"
+     "CONFIG_NO_HZ_FULL=y\n"
+     "CONFIG_RCU_NOCB_CPU=y\n"
+     "CONFIG_TRANSPARENT_HUGEPAGE_MADVISE=y\n"
+     "# CONFIG_TRANSPARENT_HUGEPAGE_ALWAYS is not set\n"},
+
+    {"throughput-server", "No forced preemption, 100 Hz, THP always, no autogroup",
+     "CONFIG_PREEMPT_NONE=y\n"
+     "# CONFIG_PREEMPT_VOLUNTARY is not set\n"
+     "# CONFIG_PREEMPT is not set\n"
+     "CONFIG_HZ_100=y\n"
+     "# CONFIG_HZ_250 is not set\n"
+     "CONFIG_HZ=100\n"
+     "CONFIG_NO_HZ_IDLE=y\n"
+     "# CONFIG_NO_HZ_FULL is not set\n"
+     "CONFIG_TRANSPARENT_HUGEPAGE_ALWAYS=y\n"
+     "# CONFIG_TRANSPARENT_HUGEPAGE_MADVISE is not set\n"
+     "# CONFIG_SCHED_AUTOGROUP is not set\n"},
+
+    {"virt-guest", "KVM/virtio guest: paravirt, 100 Hz, built-in virtio drivers",
+     "CONFIG_HYPERVISOR_GUEST=y\n"
+     "CONFIG_PARAVIRT=y\n"
+     "CONFIG_PARAVIRT_SPINLOCKS=y\n"
+     "CONFIG_KVM_GUEST=y\n"
+     "CONFIG_HZ_100=y\n"
+     "# CONFIG_HZ_250 is not set\n"
+     "CONFIG_HZ=100\n"
+     "CONFIG_NO_HZ_IDLE=y\n"
+     "CONFIG_VIRTIO=y\n"
+     "CONFIG_VIRTIO_PCI=y\n"
+     "CONFIG_VIRTIO_BLK=y\n"
+     "CONFIG_VIRTIO_NET=y\n"
+     "CONFIG_VIRTIO_CONSOLE=y\n"},
+
+    // Fin de la lista
+    {NULL, NULL, NULL}
+};
+
+KernelPreset* find_preset(const char *name) {
+    for (int i = 0; kernel_presets[i].name != NULL; i++) {
+        if (strcmp(kernel_presets[i].name, name) == 0) {
+            return &kernel_presets[i];
+        }
+    }
+    return NULL;
+}
+
+// Un preset también puede ser un archivo de fragmento propio (--preset=./mi-fragmento.config)
+int preset_is_file(const char *name) {
+    return strchr(name, '/') != NULL;
+}
+
+int preset_exists(const char *name) {
+    struct stat st;
+    if (preset_is_file(name)) {
+        return stat(name, &st) == 0 && S_ISREG(st.st_mode);
+    }
+    return find_preset(name) != NULL;
+}
+
+void list_presets() {
+    printf(_("Available presets:\n"));
+    for (int i = 0; kernel_presets[i].name != NULL; i++) {
+        printf("  %-18s %s\n", kernel_presets[i].name, kernel_presets[i].description);
+    }
+    printf(_("A path to your own config fragment is accepted as well.\n"));
+}
+
+// Carga un archivo completo en memoria, precedido por '\n' para poder buscar "\nCONFIG_X="
+char* read_config_file(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buf = malloc(size + 2);
+    if (!buf) {
+        fclose(fp);
+        return NULL;
+    }
+    buf[0] = '\n';
+    size_t n = fread(buf + 1, 1, size, fp);
+    buf[n + 1] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+// Compara cada símbolo pedido en el fragmento con el .config final.
+// Devuelve la cantidad de símbolos que no quedaron como se pidió.
+int validate_preset(const char *source_dir, const char *fragment_path) {
+    char config_path[1024];
+    snprintf(config_path, sizeof(config_path), "%s/.config", source_dir);
+
+    char *config = read_config_file(config_path);
+    FILE *fp = fopen(fragment_path, "r");
+    if (!config || !fp) {
+        free(config);
+        if (fp) fclose(fp);
+        fprintf(stderr, _("Could not validate the preset against .config\n"));
+        return -1;
+    }
+
+    char line[512];
+    int missing = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char *newline = strchr(line, '\n');
+        if (newline) *newline = '\0';
+
+        char symbol[256];
+        char pattern[600];
+        int want_unset = 0;
+
+        if (sscanf(line, "# CONFIG_%255s is not set", symbol) == 1) {
+            want_unset = 1;
+        } else if (strncmp(line, "CONFIG_", 7) == 0 && strchr(line, '=')) {
+            snprintf(symbol, sizeof(symbol), "%.*s", (int)(strchr(line, '=') - line - 7), line + 7);
+        } else {
+            continue;
+        }
+
+        int ok;
+        if (want_unset) {
+            // Sin definir o explícitamente "is not set", ambos valen
+            snprintf(pattern, sizeof(pattern), "\nCONFIG_%s=", symbol);
+            ok = (strstr(config, pattern) == NULL);
+        } else {
+            snprintf(pattern, sizeof(pattern), "\n%s\n", line);
+            ok = (strstr(config, pattern) != NULL);
+        }
+
+        if (!ok) {
+            if (missing == 0) {
+                printf(_("The following preset options did not take effect:\n"));
+            }
+            printf("  %s\n", line);
+            missing++;
+        }
+    }
+
+    fclose(fp);
+    free(config);
+
+    if (missing == 0) {
+        printf(_("All preset options were applied.\n"));
+    } else {
+        printf(_("(usually an unmet dependency or an option not available for this architecture)\n"));
+    }
+    return missing;
+}
+
+// Mezcla el preset elegido en el .config y valida el resultado
+void apply_preset(const char *source_dir, const char *name) {
+    if (!name || strcmp(name, "none") == 0) return;
+
+    char fragment_path[1024];
+    char cmd[2048];
+
+    if (preset_is_file(name)) {
+        snprintf(fragment_path, sizeof(fragment_path), "%s", name);
+    } else {
+        KernelPreset *preset = find_preset(name);
+        if (!preset) {
+            fprintf(stderr, _("Unknown preset: %s\n"), name);
+            exit(EXIT_FAILURE);
+        }
+
+        snprintf(fragment_path, sizeof(fragment_path), "%s/.preset-%s.config", source_dir, name);
+        FILE *fp = fopen(fragment_path, "w");
+        if (!fp) {
+            perror(_("Failed to write preset fragment"));
+            exit(EXIT_FAILURE);
+        }
+        fputs(preset->fragment, fp);
+        fclose(fp);
+    }
+
+    printf(_("Applying preset %s...\n"), name);
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && scripts/kconfig/merge_config.sh -m .config %s && make %s olddefconfig",
+             source_dir, fragment_path, profile_make_vars());
+    run(cmd);
+
+    validate_preset(source_dir, fragment_path);
+}
+
+#endif
@@ -0,0 +1,102 @@
+// Perfil optimizado: Clang + ThinLTO + -march nativo, con vuelta a GCC.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "../distro/common.h"
+
+// Herramientas que usa make LLVM=1 (ld.lld incluido)
+static const char *LLVM_TOOLS[] = {
+    "clang", "ld.lld", "llvm-ar", "llvm-nm", "llvm-objcopy", "llvm-strip", NULL
+};
+
+const char* profile_name(BuildProfile profile) {
+    return (profile == PROFILE_OPTIMIZED) ? "optimized" : "default";
+}
+
+// Variables de make para el perfil activo
+const char* profile_make_vars() {
+    return (build_opts.profile == PROFILE_OPTIMIZED) ? "LLVM=1" : "";
+}
+
+int profile_toolchain_available() {
+    char cmd[128];
+    for (int i = 0; LLVM_TOOLS[i] != NULL; i++) {
+        snprintf(cmd, sizeof(cmd), "command -v %s > /dev/null 2>&1", LLVM_TOOLS[i]);
+        if (system(cmd) != 0) {
+            fprintf(stderr, _("Optimized profile: %s not found.\n"), LLVM_TOOLS[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Se llama antes de configurar: si no hay toolchain, volvemos al perfil por defecto
+void profile_resolve() {
+    if (build_opts.profile != PROFILE_OPTIMIZED) return;
+
+    if (!profile_toolchain_available()) {
+        printf(_("LLVM toolchain is incomplete. Falling back to the default GCC build.\n"));
+        build_opts.profile = PROFILE_DEFAULT;
+        return;
+    }
+    printf(_("Using optimized build profile (Clang, ThinLTO, ld.lld).\n"));
+}
+
+// Devuelve 1 si el símbolo quedó como =y en el .config
+int config_symbol_enabled(const char *source_dir, const char *symbol) {
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "grep -q '^CONFIG_%s=y' %s/.config", symbol, source_dir);
+    return system(cmd) == 0;
+}
+
+// El kernel trae X86_NATIVE_CPU (-march=native) desde 6.16. En otras arquitecturas
+// mainline no ofrece una opción equivalente, así que no hacemos nada.
+int profile_has_native_cpu_option(const char *source_dir) {
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd),
+             "[ \"$(uname -m)\" = x86_64 ] && grep -q '^config X86_NATIVE_CPU' %s/arch/x86/Kconfig.cpu 2>/dev/null",
+             source_dir);
+    return system(cmd) == 0;
+}
+
+// Activa ThinLTO y la optimización nativa sobre el .config ya generado por oldconfig
+void profile_apply_config(const char *source_dir) {
+    if (build_opts.profile != PROFILE_OPTIMIZED) return;
+
+    char cmd[2048];
+    int native = profile_has_native_cpu_option(source_dir);
+
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && scripts/config --file .config -d LTO_NONE -e LTO_CLANG_THIN %s && "
+             "make %s olddefconfig",
+             source_dir, native ? "-e X86_NATIVE_CPU" : "", profile_make_vars());
+    run(cmd);
+
+    if (!config_symbol_enabled(source_dir, "LTO_CLANG_THIN")) {
+        printf(_("Warning: this kernel/architecture does not allow ThinLTO, building without LTO.\n"));
+    }
+    if (!native) {
+        printf(_("Host-native CPU optimization is not available for this kernel/architecture.\n"));
+    } else if (!config_symbol_enabled(source_dir, "X86_NATIVE_CPU")) {
+        printf(_("Warning: CONFIG_X86_NATIVE_CPU could not be enabled.\n"));
+    }
+}
+
+// Si la compilación con Clang falla, limpiamos los objetos y volvemos a GCC
+void profile_fallback_to_gcc(const char *source_dir) {
+    char cmd[2048];
+
+    printf(_("Optimized build failed. Retrying with the default GCC profile...\n"));
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && make %s clean && "
+             "scripts/config --file .config -d LTO_CLANG_THIN -e LTO_NONE -d X86_NATIVE_CPU",
+             source_dir, profile_make_vars());
+    run(cmd);
+
+    build_opts.profile = PROFILE_DEFAULT;
+    snprintf(cmd, sizeof(cmd), "cd %s && make olddefconfig", source_dir);
+    run(cmd);
+}
+
+#endif
@@ -0,0 +1,217 @@
+// Clave MOK y firma de módulos en paralelo (Mint/Ubuntu).
+
+#ifndef SIGNING_H
+#define SIGNING_H
+
+#include <time.h>
+
+#include "../distro/common.h"
+#include "profile.h"
+#include "extract.h"
+
+#define MOK_DIR       "/var/lib/shim-signed/mok"
+#define MOK_KEY_PATH  MOK_DIR "/MOK_goldendoglinux.priv"
+#define MOK_CERT_PATH MOK_DIR "/MOK_goldendoglinux.der"
+
+// Certificado en PEM para CONFIG_SYSTEM_TRUSTED_KEYS, en ~/kernel_build (fuera del árbol:
+// extract_restore_full rehace el árbol y solo conserva el .config)
+#define SIGNING_CERT_FILE "mok_goldendoglinux.pem"
+
+// El certificado tiene que seguir vigente al menos 30 días más
+#define MOK_MIN_VALID_SECONDS (30L * 24 * 3600)
+
+// --watch no puede pedir la contraseña: ahí sudo -n falla en lugar de esperar
+static const char* mok_sudo() {
+    return build_opts.watch ? "sudo -n" : "sudo";
+}
+
+static int mok_key_is_ecdsa() {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "%s openssl x509 -inform DER -in " MOK_CERT_PATH " -noout -text 2>/dev/null "
+             "| grep -q id-ecPublicKey", mok_sudo());
+    return system(cmd) == 0;
+}
+
+// 1 si hay un par de claves utilizable: certificado vigente, clave privada que
+// le corresponde y del tipo pedido con --mok-key (si se pidió alguno)
+int mok_keypair_valid() {
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd),
+             "sudo test -f " MOK_KEY_PATH " && sudo test -f " MOK_CERT_PATH " && "
+             "sudo openssl x509 -inform DER -in " MOK_CERT_PATH " -noout -checkend %ld > /dev/null 2>&1",
+             MOK_MIN_VALID_SECONDS);
+    if (system(cmd) != 0) return 0;
+
+    // La clave pública del certificado y la de la clave privada tienen que coincidir
+    if (system("test \"$(sudo openssl x509 -inform DER -in " MOK_CERT_PATH " -noout -pubkey 2>/dev/null)\" = "
+               "\"$(sudo openssl pkey -in " MOK_KEY_PATH " -pubout 2>/dev/null)\"") != 0) {
+        printf(_("The Secure Boot certificate does not match its private key.\n"));
+        return 0;
+    }
+
+    if (build_opts.mok_key_type) {
+        int want_ecdsa = strcmp(build_opts.mok_key_type, "ecdsa") == 0;
+        if (want_ecdsa != mok_key_is_ecdsa()) {
+            printf(_("The existing Secure Boot key is not %s, generating a new one.\n"),
+                   build_opts.mok_key_type);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+const char* mok_newkey_args() {
+    if (build_opts.mok_key_type && strcmp(build_opts.mok_key_type, "ecdsa") == 0) {
+        return "-newkey ec -pkeyopt ec_paramgen_curve:prime256v1";
+    }
+    return "-newkey rsa:2048";
+}
+
+// Algoritmo de hash que usa el kernel para las firmas (CONFIG_MODULE_SIG_HASH)
+static void signing_hash_algo(const char *source_dir, char *out, size_t size) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/.config", source_dir);
+    snprintf(out, size, "sha512");
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char algo[32];
+        if (sscanf(line, "CONFIG_MODULE_SIG_HASH=\"%31[^\"]\"", algo) == 1) {
+            snprintf(out, size, "%s", algo);
+            break;
+        }
+    }
+    fclose(fp);
+}
+
+// Copia en PEM del certificado MOK junto a los árboles. Si la clave se regeneró,
+// make vuelve a armar la lista de certificados del kernel al compilar.
+static int signing_export_cert(const char *source_dir, char *cert, size_t size) {
+    char parent[512], cmd[2048];
+    extract_parent_dir(source_dir, parent, sizeof(parent));
+    snprintf(cert, size, "%s/" SIGNING_CERT_FILE, parent);
+
+    snprintf(cmd, sizeof(cmd), "%s openssl x509 -inform DER -in " MOK_CERT_PATH " -outform PEM > %s 2>/dev/null",
+             mok_sudo(), cert);
+    return system(cmd) == 0 ? 0 : -1;
+}
+
+// Al configurar: el kernel confía en el certificado MOK (solo la parte pública) y no
+// firma los módulos al instalarlos, porque de eso se encarga sign_modules_parallel.
+// La clave privada no sale de MOK_DIR.
+void signing_configure(const char *source_dir) {
+    // --direct instala con make modules_install, que firma con la clave propia del kernel
+    if (build_opts.direct || !config_symbol_enabled(source_dir, "MODULE_SIG")) return;
+
+    char cert[640], cmd[2048];
+    if (signing_export_cert(source_dir, cert, sizeof(cert)) != 0) {
+        // Con --watch la clave todavía puede no existir: se configura al firmar
+        if (!build_opts.watch) {
+            fprintf(stderr, _("Could not read the Secure Boot certificate, modules will be signed with the kernel's own key.\n"));
+        }
+        return;
+    }
+
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && scripts/config --file .config --set-str SYSTEM_TRUSTED_KEYS %s"
+             " -d MODULE_SIG_ALL %s && make %s olddefconfig",
+             source_dir, cert, mok_key_is_ecdsa() ? "-e CRYPTO_ECDSA" : "", profile_make_vars());
+    run(cmd);
+}
+
+// 1 si signing_configure dejó el .config listo para firmar los módulos en paralelo
+int signing_configured(const char *source_dir) {
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd),
+             "grep -q '^CONFIG_SYSTEM_TRUSTED_KEYS=\".*/" SIGNING_CERT_FILE "\"' %s/.config && "
+             "! grep -q '^CONFIG_MODULE_SIG_ALL=y' %s/.config",
+             source_dir, source_dir);
+    return config_symbol_enabled(source_dir, "MODULE_SIG") && system(cmd) == 0;
+}
+
+// Antes de firmar (ya en la ejecución interactiva): el certificado al día y, si
+// --watch configuró el árbol sin poder leerlo, la configuración de firma.
+// Devuelve 1 si los módulos se pueden firmar en paralelo.
+int signing_refresh(const char *source_dir) {
+    if (!config_symbol_enabled(source_dir, "MODULE_SIG")) return 0;
+
+    char cert[640];
+    if (signing_configured(source_dir)) {
+        return signing_export_cert(source_dir, cert, sizeof(cert)) == 0;
+    }
+    signing_configure(source_dir);
+    record_config_hash(source_dir);
+    return signing_configured(source_dir);
+}
+
+static long signing_count_modules(const char *source_dir) {
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "find %s -name '*.ko' | wc -l", source_dir);
+    FILE *fp = popen(cmd, "r");
+    if (!fp) return 0;
+    char buf[32] = "";
+    if (!fgets(buf, sizeof(buf), fp)) buf[0] = '\0';
+    pclose(fp);
+    return atol(buf);
+}
+
+// Firma (y con --boot-optimized, antes quita la depuración de) todos los módulos
+// compilados, repartidos entre las CPUs. Devuelve los segundos que llevó.
+long sign_modules_parallel(const char *source_dir, const char *version) {
+    char hash[32];
+    signing_hash_algo(source_dir, hash, sizeof(hash));
+
+    char jobs[16];
+    if (build_opts.jobs > 0) snprintf(jobs, sizeof(jobs), "%d", build_opts.jobs);
+    else snprintf(jobs, sizeof(jobs), "$(nproc)");
+
+    // strip después de firmar borraría la firma, así que va antes y en el mismo paso
+    const char *strip = build_opts.boot_optimized ? "strip --strip-debug \"$m\" && " : "";
+
+    // sign-file lee la clave directamente de MOK_DIR, así que firma como root; los
+    // módulos firmados se devuelven al usuario para que make no tropiece con ellos.
+    // El primer sudo pide la contraseña antes de lanzar los procesos en paralelo.
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && sudo test -r " MOK_KEY_PATH " && "
+             "find . -name '*.ko' -print0 | xargs -0 -r -n 32 -P %s sudo sh -c "
+             "'k=$1; c=$2; shift 2; for m; do %sscripts/sign-file %s \"$k\" \"$c\" \"$m\" "
+             "&& chown %d:%d \"$m\" || exit 255; done' sh " MOK_KEY_PATH " " MOK_CERT_PATH,
+             source_dir, jobs, strip, hash, (int)getuid(), (int)getgid());
+
+    long modules = signing_count_modules(source_dir);
+    printf(_("Signing %ld modules in parallel...\n"), modules);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run(cmd);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    build_opts.presigned_modules = 1;
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    const char *key = mok_key_is_ecdsa() ? "ecdsa" : "rsa";
+
+    printf("\n========================================\n");
+    printf(_("Module signing: %ld modules, %s key, %s, %.1f s\n"), modules, key, hash, seconds);
+    printf("========================================\n\n");
+
+    const char *home = getenv("HOME");
+    if (home) {
+        char log_path[512];
+        snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+        FILE *fp = fopen(log_path, "a");
+        if (fp) {
+            char stamp[32];
+            time_t now = time(NULL);
+            strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+            fprintf(fp, "%s signing=%s modules=%ld key=%s hash=%s seconds=%.1f\n",
+                    stamp, version, modules, key, hash, seconds);
+            fclose(fp);
+        }
+    }
+    return (long)seconds;
+}
+
+#endif
@@ -0,0 +1,141 @@
+// Árboles de trabajo copiados de un prístino por versión (reflink o copia normal).
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <time.h>
+#include <sys/wait.h>
+
+#include "../distro/common.h"
+#include "extract.h"
+
+#define SNAPSHOT_DIR_NAME "pristine"
+// Se escribe al terminar la extracción: un prístino a medio extraer no se usa
+#define SNAPSHOT_READY_SUFFIX ".ready"
+
+// <dir>/linux-X -> <dir>/pristine/linux-X y el tarball <dir>/linux-X.tar.xz
+static void snapshot_paths(const char *source_dir, char *pristine, size_t pristine_size,
+                           char *tarball, size_t tarball_size) {
+    char parent[512];
+    extract_parent_dir(source_dir, parent, sizeof(parent));
+    const char *name = strrchr(source_dir, '/');
+    name = name ? name + 1 : source_dir;
+
+    snprintf(pristine, pristine_size, "%s/" SNAPSHOT_DIR_NAME "/%s", parent, name);
+    snprintf(tarball, tarball_size, "%s.tar.xz", source_dir);
+}
+
+static int snapshot_ready(const char *pristine) {
+    char marker[640];
+    struct stat st;
+    snprintf(marker, sizeof(marker), "%s" SNAPSHOT_READY_SUFFIX, pristine);
+    return stat(marker, &st) == 0;
+}
+
+// Qué sabe hacer el sistema de archivos de ~/kernel_build/pristine: se prueba con un
+// archivo chico antes de extraer nada. "reflink", "copy" o NULL. Sin reflink se copia
+// de verdad: un árbol de enlaces duros comparte los inodos con el prístino, y al
+// protegerlo con permisos de solo lectura los 0444 terminaban en linux-headers y
+// rompían las ediciones en el lugar.
+static const char* snapshot_mode(const char *pristine_dir) {
+    static char checked_dir[600] = "";
+    static const char *mode = NULL;
+    if (strcmp(checked_dir, pristine_dir) == 0) return mode;
+    snprintf(checked_dir, sizeof(checked_dir), "%s", pristine_dir);
+
+    // Nombres únicos: varias compilaciones pueden estar probando el mismo directorio
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd),
+             "mkdir -p %s && p=$(mktemp -p %s .probe.XXXXXX) && echo probe > \"$p\" || exit 2; "
+             "if cp --reflink=always \"$p\" \"$p.copy\" 2>/dev/null; then r=0; else r=1; fi; "
+             "rm -f \"$p\" \"$p.copy\"; exit $r",
+             pristine_dir, pristine_dir);
+    int status = system(cmd);
+    int result = WIFEXITED(status) ? WEXITSTATUS(status) : 2;
+    mode = result == 0 ? "reflink" : result == 1 ? "copy" : NULL;
+    return mode;
+}
+
+// Extrae el prístino si falta, o si hace falta completo y el que hay está filtrado
+static void snapshot_prepare_pristine(const char *pristine, const char *tarball, int full) {
+    if (snapshot_ready(pristine) && !(full && extract_is_filtered(pristine))) return;
+
+    char marker[640];
+    snprintf(marker, sizeof(marker), "%s" SNAPSHOT_READY_SUFFIX, pristine);
+    unlink(marker);
+
+    printf(_("Extracting the pristine source tree %s...\n"), pristine);
+    if (full || extract_source_filtered(tarball, pristine) != 0) {
+        if (!full) printf(_("Filtered extraction not possible, extracting the full tarball.\n"));
+        extract_source_full(tarball, pristine);
+    }
+
+    FILE *fp = fopen(marker, "w");
+    if (fp) fclose(fp);
+}
+
+// Crea source_dir desde cero (si ya existía se descarta). Con full, el árbol queda
+// completo aunque el prístino estuviera filtrado.
+void snapshot_create_tree(const char *source_dir, int full) {
+    char pristine[600], tarball[600], pristine_dir[600], cmd[2048];
+    snapshot_paths(source_dir, pristine, sizeof(pristine), tarball, sizeof(tarball));
+    extract_parent_dir(pristine, pristine_dir, sizeof(pristine_dir));
+
+    const char *mode = snapshot_mode(pristine_dir);
+    if (!mode) {
+        printf(_("Copy-on-write snapshots are not supported here, extracting the tarball.\n"));
+        if (full || extract_source_filtered(tarball, source_dir) != 0) {
+            extract_source_full(tarball, source_dir);
+        }
+        return;
+    }
+
+    snapshot_prepare_pristine(pristine, tarball, full);
+
+    const char *cp_args = strcmp(mode, "reflink") == 0 ? "-a --reflink=always" : "-a";
+    time_t start = time(NULL);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s && cp %s %s %s", source_dir, cp_args, pristine, source_dir);
+    run(cmd);
+    if (strcmp(mode, "copy") == 0) {
+        // Un prístino de una versión anterior (modo hardlink) quedó de solo lectura
+        snprintf(cmd, sizeof(cmd), "chmod -R u+w %s", source_dir);
+        run(cmd);
+    }
+    extract_log(source_dir, mode, (long)(time(NULL) - start));
+}
+
+// Un árbol de enlaces duros de una versión anterior que se va a reutilizar: cada archivo
+// que todavía comparte el inodo con el prístino se reemplaza por una copia propia y escribible
+void snapshot_break_links(const char *source_dir) {
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd), "find %s/Makefile -links +1 2>/dev/null | grep -q .", source_dir);
+    if (system(cmd) != 0) return;
+
+    printf(_("Unsharing %s from the pristine copy before editing it in place...\n"), source_dir);
+    time_t start = time(NULL);
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && find . -type f -links +1 -print0 | xargs -0 -r -n 256 -P $(nproc) sh -c "
+             "'for f; do cp -p \"$f\" \"$f.unshare\" && chmod u+w \"$f.unshare\" && "
+             "mv -f \"$f.unshare\" \"$f\" || exit 255; done' sh",
+             source_dir);
+    run(cmd);
+    extract_log(source_dir, "unshare", (long)(time(NULL) - start));
+}
+
+// Un árbol filtrado no alcanzó: se rehace completo conservando el .config
+void extract_restore_full(const char *source_dir) {
+    char cmd[2048];
+    printf(_("The filtered source tree is not enough for this build, extracting the full tarball...\n"));
+
+    snprintf(cmd, sizeof(cmd), "cp %s/.config %s.config.saved 2>/dev/null", source_dir, source_dir);
+    int saved = (system(cmd) == 0);
+
+    snapshot_create_tree(source_dir, 1);
+
+    if (saved) {
+        snprintf(cmd, sizeof(cmd), "mv %s.config.saved %s/.config", source_dir, source_dir);
+        run(cmd);
+    }
+}
+
+#endif
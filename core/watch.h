@@ -0,0 +1,99 @@
+// --watch: prepara el último stable desde un timer de systemd, sin instalar.
+
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <fcntl.h>
+#include <sys/file.h>
+
+#include "../distro/common.h"
+#include "checkpoint.h"
+
+#define BUILD_LOCK_FILE "kernel-installer.lock"
+
+// Devuelve el descriptor del lock (queda abierto hasta que termine el proceso)
+// o -1 si otra ejecución lo tiene tomado
+int acquire_build_lock(const char *build_dir) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s/" BUILD_LOCK_FILE, build_dir);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// --watch corre desde un servicio de usuario, sin terminal para pedir la contraseña de
+// sudo: si algo necesita root y sudo -n no alcanza, se falla enseguida en vez de colgarse
+void watch_require_root(const char *what) {
+    if (!build_opts.watch || system("sudo -n true > /dev/null 2>&1") == 0) return;
+
+    char message[512];
+    snprintf(message, sizeof(message), "%s needs root and sudo asks for a password", what);
+    fprintf(stderr, _("%s needs root, but sudo asks for a password and --watch has no terminal. "
+                      "Run kernel-installer interactively.\n"), what);
+    event_message("error", message);
+    checkpoint_record_failure("sudo -n true");
+    exit(EXIT_FAILURE);
+}
+
+// 1 si hay que preparar un kernel (el checkpoint queda apuntando a esa versión),
+// 0 si no hay nada que hacer y -1 si no se pudo consultar kernel.org
+int watch_check_release(const char *home, const char *tag, Distro distro) {
+    char latest[32];
+    if (fetch_kernel_version("stable", latest, sizeof(latest)) != 0) {
+        fprintf(stderr, _("Could not fetch latest kernel version.\n"));
+        return -1;
+    }
+
+    char kernel_path[512];
+    struct stat st;
+    snprintf(kernel_path, sizeof(kernel_path), "/boot/vmlinuz-%s%s", latest, tag);
+    if (stat(kernel_path, &st) == 0) {
+        printf(_("Kernel %s%s is already installed, nothing to do.\n"), latest, tag);
+        return 0;
+    }
+
+    if (checkpoint_load(home)) {
+        if (strcmp(checkpoint.version, latest) == 0) {
+            if (checkpoint_done(PHASE_BUILD) && are_packages_built(home, latest, checkpoint.tag, distro)) {
+                printf(_("Packages for %s%s are ready, run kernel-installer to install them.\n"),
+                       latest, checkpoint.tag);
+                return 0;
+            }
+            // En Mint la firma y el empaquetado necesitan root: el kernel queda compilado
+            char source_dir[512];
+            snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, latest);
+            if (distro == DISTRO_MINT && checkpoint_done(PHASE_CONFIGURE) &&
+                is_kernel_built(source_dir, latest, checkpoint.tag)) {
+                printf(_("Kernel %s%s is compiled, run kernel-installer to sign, package and install it.\n"),
+                       latest, checkpoint.tag);
+                return 0;
+            }
+            return 1;
+        }
+
+        // Una ejecución interactiva que ya empezó a instalar no se toca
+        if (checkpoint_done(PHASE_INSTALL) || checkpoint.failed >= PHASE_INSTALL) {
+            printf(_("An unfinished install of %s%s is pending, not preparing %s.\n"),
+                   checkpoint.version, checkpoint.tag, latest);
+            return 0;
+        }
+        printf(_("Replacing the unfinished run for %s with the new release %s.\n"), checkpoint.version, latest);
+        checkpoint_clear();
+        checkpoint_load(home);
+    }
+
+    snprintf(checkpoint.version, sizeof(checkpoint.version), "%s", latest);
+    snprintf(checkpoint.tag, sizeof(checkpoint.tag), "%s", tag);
+    printf(_("New stable kernel %s: preparing its packages in the background.\n"), latest);
+    return 1;
+}
+
+#endif
@@ -11,6 +11,17 @@
 
 #define _(string) gettext(string)
 
+// Registro de compilaciones dentro de ~/kernel_build
+#define BUILD_STATS_LOG "build-stats.log"
+
+// Orígenes externos. Cada uno se puede redirigir con una variable de entorno
+// (KERNEL_INSTALLER_MIRROR, ..._RELEASES_URL, ..._OS_RELEASE, ..._BASE_CONFIG,
+// ..._DPKG_STATUS); bench/ los usa para correr sin red ni root.
+#define KERNEL_MIRROR_URL   "https://cdn.kernel.org/pub/linux/kernel"
+#define KERNEL_RELEASES_URL "https://www.kernel.org/"
+#define OS_RELEASE_PATH     "/etc/os-release"
+#define BASE_CONFIG_PATH    "/boot/config-$(uname -r)"
+
 typedef enum {
     DISTRO_DEBIAN,
     DISTRO_MINT,    // Linux Mint y Ubuntu
@@ -23,19 +34,61 @@ typedef enum {
 typedef struct {
     const char* name;
     void (*install_dependencies)();
-    void (*build_and_install)(const char* home, const char* version, const char* tag);
+    void (*configure_kernel)(const char* source_dir);   // ajustes propios sobre el .config, NULL = ninguno
+    void (*build_packages)(const char* home, const char* version, const char* tag);
+    void (*install_packages)(const char* home, const char* version, const char* tag);
     void (*update_bootloader)();
-    const char* (*get_whiptail_install_cmd)();
+    void (*minimal_initramfs)(int enable);  // 1 escribe la config de initramfs mínimo, 0 la borra
+    void (*get_initramfs_path)(const char* kernel_version, char* out, size_t size);
+    void (*install_image)(const char* source_dir, const char* kernel_version); // --direct, sin paquetes
 } DistroOperations;
 
+typedef enum {
+    PROFILE_DEFAULT,    // GCC con la config de la distro
+    PROFILE_OPTIMIZED   // Clang + ThinLTO + optimización nativa
+} BuildProfile;
+
+// Opciones elegidas por línea de comandos
+typedef struct {
+    BuildProfile profile;
+    const char* preset;     // nombre de preset, ruta a un fragmento o "none"
+    const char* targets;    // lista de ramas/versiones para el modo multi-target
+    int jobs;               // 0 = $(nproc)
+    const char* cpu_list;   // CPUs asignadas (taskset), NULL = todas
+    int plain_progress;     // salida de make sin ncurses (procesos hijos)
+    int boot_optimized;     // módulos strip + zstd e initramfs mínimo
+    int headless;           // sin diálogos ni ncurses, eventos JSON por stdout
+    const char* progress_socket; // socket Unix para publicar los eventos, NULL = ninguno
+    const char* mok_key_type;    // "rsa" o "ecdsa" para la clave MOK, NULL = reutilizar la que haya
+    int presigned_modules;  // los módulos ya se firmaron en paralelo: modules_install no los toca
+    int background;         // compilar con límites de CPU y E/S (cgroup o nice/ionice)
+    int watch;              // preparar el último stable sin instalarlo (timer de systemd)
+    int perf_check;         // solo comparar el rendimiento del kernel nuevo con la línea base
+    int direct;             // compilación incremental e instalación directa, sin paquetes
+    int skip_space_check;   // compilar aunque la estimación de espacio no alcance
+} BuildOptions;
+
+extern BuildOptions build_opts;
+
 // Funciones comunes
+const char* env_or_default(const char *name, const char *fallback);
 int run(const char *cmd);
+int file_sha256(const char *filepath, char *out, size_t size);
+void fail_command(const char *cmd, int status);
 int run_build_with_progress(const char *cmd, const char *source_dir);
+int count_source_files(const char *dir);
+int is_compile_line(const char *line);
+int fetch_kernel_version(const char *moniker, char *out, size_t size);
+void fetch_kernel_source(const char *home, const char *version);
+void configure_kernel_tree(const char *home, const char *version, const char *tag);
+void record_config_hash(const char *source_dir);
+int is_kernel_built(const char *source_dir, const char *version, const char *tag);
+int are_packages_built(const char *home, const char *version, const char *tag, Distro distro);
+void checkpoint_record_failure(const char *cmd);
 Distro detect_distro();
 DistroOperations* get_distro_operations(Distro distro);
 
 // Funciones de UI
-int check_and_install_whiptail(Distro distro);
 int show_welcome_dialog();
 int ask_cleanup();
 void show_completion_dialog(const char *kernel_version, Distro distro);
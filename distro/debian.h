@@ -7,24 +7,27 @@
 #define DEBIAN_H
 
 #include "common.h"
+#include "../core/build.h"
+#include "../core/deps.h"
 
 void debian_install_dependencies() {
-    run("sudo apt update && sudo apt install -y "
-        "build-essential libncurses-dev bison flex libssl-dev libelf-dev "
-        "bc wget tar xz-utils gettext libc6-dev fakeroot curl git debhelper libdw-dev rsync locales");
+    deps_install(PKGDB_DPKG,
+                 "build-essential libncurses-dev bison flex libssl-dev libelf-dev "
+                 "bc tar xz-utils gettext libc6-dev fakeroot curl git debhelper libdw-dev rsync locales",
+                 "sudo apt update && sudo apt install -y");
 }
 
-void debian_build_and_install(const char* home, const char* version, const char* tag) {
-    char cmd[2048];
+void debian_build_packages(const char* home, const char* version, const char* tag) {
+    (void)tag;
     char source_dir[512];
     
     snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, version);
     
-    snprintf(cmd, sizeof(cmd),
-             "cd %s && fakeroot make -j$(nproc) bindeb-pkg",
-             source_dir);
-    run_build_with_progress(cmd, source_dir);
-    
+    build_kernel_packages(source_dir, version, "bindeb-pkg", 1);
+}
+
+void debian_install_packages(const char* home, const char* version, const char* tag) {
+    char cmd[2048];
     snprintf(cmd, sizeof(cmd),
              "cd %s/kernel_build && "
              "sudo dpkg -i linux-image-%s*%s*.deb linux-headers-%s*%s*.deb",
@@ -36,16 +39,54 @@ void debian_update_bootloader() {
     run("sudo update-grub");
 }
 
-const char* debian_get_whiptail_install_cmd() {
-    return "sudo apt update && sudo apt install -y whiptail";
+// Initramfs solo con los módulos que necesita este equipo y compresión rápida.
+// initramfs-tools no acepta opciones por kernel: la configuración está solo mientras
+// dpkg instala el paquete (el postinst genera el initramfs una vez, con ella) y se borra
+// después, así no afecta a los initramfs de los demás kernels.
+#define DEBIAN_INITRAMFS_CONF "/etc/initramfs-tools/conf.d/kernel-installer.conf"
+
+void debian_minimal_initramfs(int enable) {
+    if (enable) {
+        run("printf 'MODULES=dep\\nCOMPRESS=zstd\\nCOMPRESSLEVEL=1\\n' | "
+            "sudo tee " DEBIAN_INITRAMFS_CONF " > /dev/null");
+    } else if (system("sudo rm -f " DEBIAN_INITRAMFS_CONF) != 0) {
+        fprintf(stderr, _("Warning: could not remove %s\n"), DEBIAN_INITRAMFS_CONF);
+    }
+}
+
+void debian_get_initramfs_path(const char* kernel_version, char* out, size_t size) {
+    snprintf(out, size, "/boot/initrd.img-%s", kernel_version);
+}
+
+// --direct: imagen, System.map y config a /boot y un initramfs nuevo, sin pasar por dpkg
+void debian_install_image(const char* source_dir, const char* kernel_version) {
+    char image[1024];
+    if (get_kernel_image_path(source_dir, image, sizeof(image)) != 0) {
+        fprintf(stderr, _("Could not determine the kernel image path.\n"));
+        exit(EXIT_FAILURE);
+    }
+
+    char cmd[4096];
+    snprintf(cmd, sizeof(cmd),
+             "sudo cp %s /boot/vmlinuz-%s && "
+             "sudo cp %s/System.map /boot/System.map-%s && "
+             "sudo cp %s/.config /boot/config-%s && "
+             "sudo rm -f /boot/initrd.img-%s && "
+             "sudo update-initramfs -c -k %s",
+             image, kernel_version, source_dir, kernel_version, source_dir, kernel_version,
+             kernel_version, kernel_version);
+    run(cmd);
 }
 
 DistroOperations DEBIAN_OPS = {
     .name = "Debian",
     .install_dependencies = debian_install_dependencies,
-    .build_and_install = debian_build_and_install,
+    .build_packages = debian_build_packages,
+    .install_packages = debian_install_packages,
     .update_bootloader = debian_update_bootloader,
-    .get_whiptail_install_cmd = debian_get_whiptail_install_cmd
+    .minimal_initramfs = debian_minimal_initramfs,
+    .get_initramfs_path = debian_get_initramfs_path,
+    .install_image = debian_install_image
 };
 
 #endif
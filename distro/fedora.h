@@ -3,45 +3,105 @@
 #ifndef FEDORA_H
 #define FEDORA_H
 
+#include <sys/utsname.h>
+
 #include "common.h"
+#include "../core/build.h"
+#include "../core/deps.h"
 
 void fedora_install_dependencies() {
-    run("sudo dnf install -y "
-        "gcc make ncurses-devel bison flex openssl-devel elfutils-libelf-devel "
-        "rpm-build newt curl git wget tar xz");
+    deps_install(PKGDB_RPM,
+                 "gcc make ncurses-devel bison flex openssl-devel elfutils-libelf-devel "
+                 "rpm-build curl git tar xz",
+                 "sudo dnf install -y");
+}
+
+// make rpm-pkg arma un SRPM y después rpmbuild vuelve a compilar todo el kernel desde cero.
+// En su lugar compilamos una sola vez en el árbol y empaquetamos con binrpm-pkg,
+// que reutiliza los objetos ya compilados.
+//
+// Desde 6.5 los RPMs quedan en <fuente>/rpmbuild/RPMS/<arch>; los kernels más viejos
+// usan ~/rpmbuild. Tanto la instalación como are_packages_built() usan esta función.
+void fedora_get_rpm_dir(const char* home, const char* version, char* out, size_t size) {
+    struct utsname uts;
+    const char *arch = (uname(&uts) == 0) ? uts.machine : "x86_64";
+
+    struct stat st;
+    snprintf(out, size, "%s/kernel_build/linux-%s/rpmbuild/RPMS/%s", home, version, arch);
+    if (stat(out, &st) == 0 && S_ISDIR(st.st_mode)) return;
+
+    snprintf(out, size, "%s/rpmbuild/RPMS/%s", home, arch);
+}
+
+// rpm no admite '-' en la versión: el kernel los cambia por '_' (6.17.8-lexi-amd64 -> 6.17.8_lexi_amd64)
+void fedora_rpm_release(const char* version, const char* tag, char* out, size_t size) {
+    snprintf(out, size, "%s%s", version, tag);
+    for (char *p = out; *p; p++) {
+        if (*p == '-') *p = '_';
+    }
+}
+
+int fedora_packages_built(const char* home, const char* version, const char* tag) {
+    char rpm_dir[1024];
+    char release[128];
+    char cmd[2048];
+
+    fedora_get_rpm_dir(home, version, rpm_dir, sizeof(rpm_dir));
+    fedora_rpm_release(version, tag, release, sizeof(release));
+    snprintf(cmd, sizeof(cmd), "ls %s/kernel-%s-*.rpm 2>/dev/null | grep -q .", rpm_dir, release);
+    return system(cmd) == 0;
 }
 
-void fedora_build_and_install(const char* home, const char* version, const char* tag) {
+void fedora_build_packages(const char* home, const char* version, const char* tag) {
+    (void)tag;
     char cmd[2048];
     char source_dir[512];
     
     snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, version);
     
-    // Compilar generando RPMs
-    snprintf(cmd, sizeof(cmd),
-             "cd %s && make -j$(nproc) rpm-pkg",
-             source_dir);
-    run_build_with_progress(cmd, source_dir);
-    
-    // Instalar los RPMs generados
-    // Los RPMs suelen generarse en ~/rpmbuild/RPMS/x86_64/ o similar, pero make rpm-pkg
-    // puede dejarlos en el directorio local o en la estructura de rpmbuild por defecto.
-    // El kernel suele usar su propia estructura interna si no se define otra cosa,
-    // pero rpm-pkg usa la infraestructura de rpmbuild del usuario.
-    // Verificaremos la ubicación estándar de rpmbuild en el home del usuario.
-    
+    // Compilar el kernel y los módulos una sola vez
+    long compile_seconds = build_kernel_packages(source_dir, version, "all", 0);
+
+    // Empaquetar solo los binarios, sin SRPM ni segunda compilación
+    time_t start = time(NULL);
+    format_make_cmd(cmd, sizeof(cmd), source_dir, "binrpm-pkg", 0);
+    int result = run_build_with_progress(cmd, source_dir);
+    if (result != 0) fail_command(cmd, result);
+    long package_seconds = (long)(time(NULL) - start);
+
+    // rpm-pkg hubiera repetido la compilación dentro de rpmbuild
+    char duration[64];
+    format_duration(package_seconds, duration, sizeof(duration));
+    printf(_("Binary RPM packaging took %s\n"), duration);
+    format_duration(compile_seconds, duration, sizeof(duration));
+    printf(_("Time saved by skipping the rpmbuild recompilation: ~%s\n"), duration);
+
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/kernel_build/" BUILD_STATS_LOG, home);
+    FILE *fp = fopen(log_path, "a");
+    if (fp) {
+        char stamp[32];
+        time_t now = time(NULL);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+        fprintf(fp, "%s binrpm=%s package_seconds=%ld saved_seconds=%ld\n",
+                stamp, version, package_seconds, compile_seconds);
+        fclose(fp);
+    }
+}
+
+void fedora_install_packages(const char* home, const char* version, const char* tag) {
+    char cmd[2048];
+    char rpm_dir[1024];
+    char release[128];
+
+    fedora_get_rpm_dir(home, version, rpm_dir, sizeof(rpm_dir));
+    fedora_rpm_release(version, tag, release, sizeof(release));
+
+    // binrpm-pkg no siempre genera kernel-devel: instalamos lo que haya
     snprintf(cmd, sizeof(cmd),
-             "cd %s/rpmbuild/RPMS/$(uname -m) && "
-             "sudo dnf install -y kernel-%s*%s*.rpm kernel-headers-%s*%s*.rpm kernel-devel-%s*%s*.rpm",
-             home, version, tag, version, tag, version, tag);
-             
-    // Nota: Si make rpm-pkg no usa ~/rpmbuild, podría necesitar ajuste.
-    // Por defecto make rpm-pkg construye en el árbol del kernel pero usa rpmbuild.
-    // Una alternativa más segura si no sabemos dónde caen es buscar en el home.
-    
-    // Vamos a intentar instalar lo que encontremos en el directorio de build del kernel si rpmbuild no está.
-    // Pero lo estándar es ~/rpmbuild. Asumiremos eso por ahora.
-    
+             "cd %s && "
+             "sudo dnf install -y $(ls kernel-%s-*.rpm kernel-headers-%s-*.rpm kernel-devel-%s-*.rpm 2>/dev/null)",
+             rpm_dir, release, release, release);
     run(cmd);
 }
 
@@ -51,16 +111,50 @@ void fedora_update_bootloader() {
     run("sudo grub2-mkconfig -o /boot/grub2/grub.cfg");
 }
 
-const char* fedora_get_whiptail_install_cmd() {
-    return "sudo dnf install -y newt";
+// dracut en modo hostonly estricto: solo los módulos de este equipo. Igual que en
+// Debian, la configuración está solo mientras se instala el paquete (kernel-install
+// corre dracut en el scriptlet del RPM) y se borra después.
+#define FEDORA_DRACUT_CONF "/etc/dracut.conf.d/kernel-installer.conf"
+
+void fedora_minimal_initramfs(int enable) {
+    if (enable) {
+        run("printf 'hostonly=\"yes\"\\nhostonly_mode=\"strict\"\\ncompress=\"zstd\"\\n' | "
+            "sudo tee " FEDORA_DRACUT_CONF " > /dev/null");
+    } else if (system("sudo rm -f " FEDORA_DRACUT_CONF) != 0) {
+        fprintf(stderr, _("Warning: could not remove %s\n"), FEDORA_DRACUT_CONF);
+    }
+}
+
+void fedora_get_initramfs_path(const char* kernel_version, char* out, size_t size) {
+    snprintf(out, size, "/boot/initramfs-%s.img", kernel_version);
+}
+
+// --direct: kernel-install copia la imagen, genera el initramfs con dracut y la entrada BLS
+void fedora_install_image(const char* source_dir, const char* kernel_version) {
+    char image[1024];
+    if (get_kernel_image_path(source_dir, image, sizeof(image)) != 0) {
+        fprintf(stderr, _("Could not determine the kernel image path.\n"));
+        exit(EXIT_FAILURE);
+    }
+
+    char cmd[4096];
+    snprintf(cmd, sizeof(cmd),
+             "sudo cp %s/System.map /boot/System.map-%s && "
+             "sudo cp %s/.config /boot/config-%s && "
+             "sudo kernel-install add %s %s",
+             source_dir, kernel_version, source_dir, kernel_version, kernel_version, image);
+    run(cmd);
 }
 
 DistroOperations FEDORA_OPS = {
     .name = "Fedora",
     .install_dependencies = fedora_install_dependencies,
-    .build_and_install = fedora_build_and_install,
+    .build_packages = fedora_build_packages,
+    .install_packages = fedora_install_packages,
     .update_bootloader = fedora_update_bootloader,
-    .get_whiptail_install_cmd = fedora_get_whiptail_install_cmd
+    .minimal_initramfs = fedora_minimal_initramfs,
+    .get_initramfs_path = fedora_get_initramfs_path,
+    .install_image = fedora_install_image
 };
 
 #endif
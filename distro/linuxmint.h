@@ -8,58 +8,73 @@
 #define LINUXMINT_H
 
 #include "common.h"
+#include "debian.h"
+#include "../core/build.h"
+#include "../core/dialog.h"
+#include "../core/deps.h"
+#include "../core/signing.h"
 
 void mint_install_dependencies() {
-    run("sudo apt update && sudo apt install -y "
-        "build-essential libncurses-dev bison flex libssl-dev libssl-dev libelf-dev "
-        "bc wget tar xz-utils fakeroot curl git debhelper libdw-dev rsync locales gawk gettext "
-        "mokutil openssl");
+    deps_install(PKGDB_DPKG,
+                 "build-essential libncurses-dev bison flex libssl-dev libelf-dev "
+                 "bc tar xz-utils fakeroot curl git debhelper libdw-dev rsync locales gawk gettext "
+                 "mokutil openssl",
+                 "sudo apt update && sudo apt install -y");
 }
 
 void mint_generate_certificate() {
+    // Se llama al instalar dependencias y otra vez antes de firmar: basta con revisar una vez
+    static int checked = 0;
+    if (checked) return;
+    checked = 1;
+
+    // Una clave nueva obliga a enrolarla otra vez en el MOK Manager: si la actual sirve, se usa
+    if (mok_keypair_valid()) {
+        printf(_("Reusing the existing GoldenDogLinux Secure Boot certificate.\n"));
+        return;
+    }
+
     printf(_("Generating GoldenDogLinux Secure Boot certificate...\n"));
     
     // Crear directorio para los certificados MOK
-    run("sudo mkdir -p /var/lib/shim-signed/mok/");
+    run("sudo mkdir -p " MOK_DIR);
     
     // Generar certificado autofirmado (válido por 10 años)
     char cmd[1024];
     snprintf(cmd, sizeof(cmd),
-             "sudo openssl req -nodes -new -x509 -newkey rsa:2048 "
-             "-keyout /var/lib/shim-signed/mok/MOK_goldendoglinux.priv "
-             "-outform DER -out /var/lib/shim-signed/mok/MOK_goldendoglinux.der "
-             "-days 3650 -subj \"/CN=GoldenDogLinux Secure Boot Key/\"");
+             "sudo openssl req -nodes -new -x509 %s "
+             "-keyout " MOK_KEY_PATH " "
+             "-outform DER -out " MOK_CERT_PATH " "
+             "-days 3650 -subj \"/CN=GoldenDogLinux Secure Boot Key/\"",
+             mok_newkey_args());
     run(cmd);
     
     // Establecer permisos adecuados para la clave privada
-    run("sudo chmod 600 /var/lib/shim-signed/mok/MOK_goldendoglinux.priv");
-    run("sudo chmod 644 /var/lib/shim-signed/mok/MOK_goldendoglinux.der");
+    run("sudo chmod 600 " MOK_KEY_PATH);
+    run("sudo chmod 644 " MOK_CERT_PATH);
     
     printf(_("GoldenDogLinux certificate generated successfully.\n"));
 }
 
 int mint_ask_secure_boot_enrollment() {
-    char command[512];
-    snprintf(command, sizeof(command),
-             "whiptail --title \"%s\" "
-             "--yesno \"%s\\n\\n"
-             "%s\\n\\n"
-             "%s\\n\\n"
-             "%s\" 16 60",
-             _("Secure Boot Enrollment"),
+    // Sin pantalla no hay quien confirme la contraseña de mokutil
+    if (build_opts.headless) return 1;
+
+    char text[1024];
+    snprintf(text, sizeof(text), "%s\n\n%s\n\n%s\n\n%s",
              _("Do you want to enroll the GoldenDogLinux certificate for Secure Boot?"),
              _("This will allow your custom kernel to work with Secure Boot enabled."),
              _("You will be asked to set a password and enroll the key during the next reboot."),
              _("Continue with enrollment?"));
-    
-    return system(command);
+
+    return dialog_yesno(_("Secure Boot Enrollment"), text, 60);
 }
 
 void mint_enroll_secure_boot_key() {
     printf(_("Enrolling GoldenDogLinux certificate for Secure Boot...\n"));
     
     // Importar el certificado MOK
-    run("sudo mokutil --import /var/lib/shim-signed/mok/MOK_goldendoglinux.der");
+    run("sudo mokutil --import " MOK_CERT_PATH);
     
     printf(_("\n=== IMPORTANT SECURE BOOT INSTRUCTIONS ===\n"));
     printf(_("1. You will be asked to set a enrollment password now\n"));
@@ -70,28 +85,57 @@ void mint_enroll_secure_boot_key() {
     printf(_("==========================================\n"));
 }
 
-void mint_build_and_install(const char* home, const char* version, const char* tag) {
+// Limpiar certificados específicos de Ubuntu/Mint y usar certificados por defecto
+void mint_clear_trusted_keys(const char* source_dir) {
     char cmd[2048];
-    
-    printf(_("Configuring GoldendogLinux Signature...\n"));
-    
-    // Limpiar certificados específicos de Ubuntu/Mint y usar certificados por defecto
     snprintf(cmd, sizeof(cmd),
-             "cd %s/kernel_build/linux-%s && "
+             "cd %s && "
              "sed -i 's/CONFIG_SYSTEM_TRUSTED_KEYS=.*/CONFIG_SYSTEM_TRUSTED_KEYS=\"\"/' .config && "
              "sed -i 's/CONFIG_SYSTEM_REVOCATION_KEYS=.*/CONFIG_SYSTEM_REVOCATION_KEYS=\"\"/' .config",
-             home, version);
+             source_dir);
     run(cmd);
+}
+
+// Ajustes del .config al configurar, antes de que se tome su hash para el checkpoint
+void mint_configure_kernel(const char* source_dir) {
+    mint_clear_trusted_keys(source_dir);
+    signing_configure(source_dir);
+}
+
+void mint_build_packages(const char* home, const char* version, const char* tag) {
+    (void)tag;
+    char cmd[2048];
     
     // Compilar el kernel
     char source_dir[512];
     snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, version);
 
-    snprintf(cmd, sizeof(cmd),
-             "cd %s && fakeroot make -j$(nproc) bindeb-pkg",
-             source_dir);
-    run_build_with_progress(cmd, source_dir);
-    
+    // --watch no tiene root: compila y deja la clave, la firma y el paquete para la
+    // ejecución interactiva, que retoma desde acá sin recompilar
+    if (build_opts.watch) {
+        build_kernel_packages(source_dir, version, "all", 0);
+        return;
+    }
+
+    mint_generate_certificate();
+    if (!signing_refresh(source_dir)) {
+        build_kernel_packages(source_dir, version, "bindeb-pkg", 1);
+        return;
+    }
+
+    // Compilar, firmar los módulos en paralelo y recién después empaquetar
+    printf(_("Configuring GoldendogLinux Signature...\n"));
+    build_kernel_packages(source_dir, version, "all", 0);
+    sign_modules_parallel(source_dir, version);
+
+    format_make_cmd(cmd, sizeof(cmd), source_dir, "bindeb-pkg", 1);
+    int result = run_build_with_progress(cmd, source_dir);
+    if (result != 0) fail_command(cmd, result);
+}
+
+void mint_install_packages(const char* home, const char* version, const char* tag) {
+    char cmd[2048];
+
     // Instalar los paquetes
     snprintf(cmd, sizeof(cmd),
              "cd %s/kernel_build && "
@@ -104,16 +148,20 @@ void mint_update_bootloader() {
     run("sudo update-grub");
 }
 
-const char* mint_get_whiptail_install_cmd() {
-    return "sudo apt update && sudo apt install -y whiptail";
+void mint_get_initramfs_path(const char* kernel_version, char* out, size_t size) {
+    snprintf(out, size, "/boot/initrd.img-%s", kernel_version);
 }
 
 DistroOperations MINT_OPS = {
     .name = "Linux Mint/Ubuntu",
     .install_dependencies = mint_install_dependencies,
-    .build_and_install = mint_build_and_install,
+    .configure_kernel = mint_configure_kernel,
+    .build_packages = mint_build_packages,
+    .install_packages = mint_install_packages,
     .update_bootloader = mint_update_bootloader,
-    .get_whiptail_install_cmd = mint_get_whiptail_install_cmd
+    .minimal_initramfs = debian_minimal_initramfs,
+    .get_initramfs_path = mint_get_initramfs_path,
+    .install_image = debian_install_image
 };
 
 #endif
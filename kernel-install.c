@@ -1,3 +1,5 @@
+#define _GNU_SOURCE  // sched_getaffinity() para el modo multi-target
+
 /*
  * Kernel Installer - Control Program
  * Copyright (C) 2025 Alexia Michelle <alexia@goldendoglinux.org>
@@ -25,12 +27,28 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/select.h>
 #include <libintl.h>
 #include <locale.h>
 #include <ncurses.h>
 
 #include "distro/common.h"
+#include "core/profile.h"
+#include "core/bootopt.h"
+#include "core/build.h"
+#include "core/presets.h"
+#include "core/multitarget.h"
+#include "core/kexec.h"
+#include "core/events.h"
+#include "core/checkpoint.h"
+#include "core/dialog.h"
+#include "core/watch.h"
+#include "core/perf.h"
+#include "core/footprint.h"
+#include "core/direct.h"
 #include "distro/debian.h"
 #include "distro/linuxmint.h"
 #include "distro/fedora.h"
@@ -40,37 +58,74 @@
 #define _(string) gettext(string)
 #define BUBU "bubu" // menos pregunta dios y perdona
 
+BuildOptions build_opts = {
+    .profile = PROFILE_DEFAULT,
+    .preset = NULL,
+    .targets = NULL,
+    .jobs = 0,
+    .cpu_list = NULL,
+    .plain_progress = 0,
+    .boot_optimized = 0,
+    .headless = 0,
+    .progress_socket = NULL,
+    .mok_key_type = NULL,
+    .presigned_modules = 0,
+    .background = 0,
+    .watch = 0,
+    .perf_check = 0,
+    .direct = 0
+};
+
 // ========== INICIO FUNC AUXILIARES ==========
 
+const char* env_or_default(const char *name, const char *fallback) {
+    const char *value = getenv(name);
+    return (value && value[0]) ? value : fallback;
+}
+
+// Un comando falló sin vuelta atrás: se informa (también como evento), se anota en
+// el checkpoint para retomar ahí y se termina
+void fail_command(const char *cmd, int status) {
+    fprintf(stderr, _(" Command failed: %s (exit %d)\n"), cmd, status);
+    char message[1200];
+    snprintf(message, sizeof(message), "command failed (exit %d): %s", status, cmd);
+    event_message("error", message);
+    checkpoint_record_failure(cmd);
+    exit(EXIT_FAILURE);
+}
+
 int run(const char *cmd) {
     printf("\n %s: %s\n", _("Running"), cmd);
     int r = system(cmd);
-    if (r != 0) {
-        fprintf(stderr, _(" Command failed: %s (exit %d)\n"), cmd, r);
-        exit(EXIT_FAILURE);
-    }
+    if (r != 0) fail_command(cmd, r);
     return r;
 }
 
 // New function to verify SHA256 checksum: If matches, kernel source do not need to be re-downloaded
-int verify_sha256(const char *filepath, const char *expected_sha256) {
+int file_sha256(const char *filepath, char *out, size_t size) {
     char cmd[1024];
     snprintf(cmd, sizeof(cmd), "sha256sum %s | awk '{print $1}'", filepath);
     
     FILE *fp = popen(cmd, "r");
-    if (!fp) return 0;
+    if (!fp) return -1;
     
-    char actual_sha256[128];
-    if (!fgets(actual_sha256, sizeof(actual_sha256), fp)) {
+    if (!fgets(out, size, fp)) {
         pclose(fp);
-        return 0;
+        return -1;
     }
     pclose(fp);
     
     // Remove newline
-    char *newline = strchr(actual_sha256, '\n');
+    char *newline = strchr(out, '\n');
     if (newline) *newline = '\0';
     
+    return 0;
+}
+
+int verify_sha256(const char *filepath, const char *expected_sha256) {
+    char actual_sha256[128];
+    if (file_sha256(filepath, actual_sha256, sizeof(actual_sha256)) != 0) return 0;
+    
     return strcmp(actual_sha256, expected_sha256) == 0;
 }
 
@@ -87,8 +142,8 @@ int get_kernel_sha256(const char *version, char *sha256_out, size_t sha256_size)
     
     char cmd[1024];
     snprintf(cmd, sizeof(cmd),
-             "wget -q -O %s https://cdn.kernel.org/pub/linux/kernel/v%c.x/sha256sums.asc",
-             tmp_sha_file, version[0]);
+             "curl -fsSL -o %s %s/v%c.x/sha256sums.asc",
+             tmp_sha_file, env_or_default("KERNEL_INSTALLER_MIRROR", KERNEL_MIRROR_URL), version[0]);
     
     if (system(cmd) != 0) {
         fprintf(stderr, "Warning: Could not download SHA256 checksums\n");
@@ -144,7 +199,64 @@ int count_source_files(const char *dir) {
     return atoi(buf);
 }
 
+// Líneas de kbuild que cuentan para la barra de progreso
+int is_compile_line(const char *line) {
+    return strstr(line, " CC ") || strstr(line, " LD ") || strstr(line, " AR ");
+}
+
+// Sin ncurses: la salida de make pasa tal cual (la usan el modo multi-target en cada hijo
+// y el modo --headless, que además publica el progreso como eventos)
+int run_build_plain(const char *cmd, const char *source_dir) {
+    int total_files = events_enabled() ? count_source_files(source_dir) : 0;
+    int current_count = 0;
+    int last_percent = -1;
+
+    char full_cmd[2048];
+    snprintf(full_cmd, sizeof(full_cmd), "%s 2>&1", cmd);
+
+    FILE *build_pipe = popen(full_cmd, "r");
+    if (!build_pipe) {
+        perror("popen build");
+        return -1;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), build_pipe)) {
+        fputs(line, stdout);
+        fflush(stdout);
+        if (is_compile_line(line)) current_count++;
+        event_build_line(NULL, line, current_count, total_files, &last_percent);
+        footprint_sample();
+    }
+    return pclose(build_pipe);
+}
+
+// Cabecera de la pantalla de progreso; con --background también lleva los límites activos
+void draw_build_header(WINDOW *header_win, int width) {
+    char header_text[256];
+    char limits[160];
+    background_describe(limits, sizeof(limits));
+    if (limits[0]) {
+        snprintf(header_text, sizeof(header_text), "Alexia Kernel Installer Version %s - %s", APP_VERSION, limits);
+    } else {
+        snprintf(header_text, sizeof(header_text), "Alexia Kernel Installer Version %s", APP_VERSION);
+    }
+    int header_len = strnlen(header_text, sizeof(header_text));
+    int header_x = (width - header_len) / 2;
+    if (header_x < 0) header_x = 0;
+
+    werase(header_win);
+    if (has_colors()) wattron(header_win, COLOR_PAIR(2) | A_BOLD);
+    mvwprintw(header_win, 0, header_x, "%s", header_text);
+    if (has_colors()) wattroff(header_win, COLOR_PAIR(2) | A_BOLD);
+    wrefresh(header_win);
+}
+
 int run_build_with_progress(const char *cmd, const char *source_dir) {
+    if (build_opts.plain_progress || build_opts.headless) {
+        return run_build_plain(cmd, source_dir);
+    }
+
     int total_files = count_source_files(source_dir);
     if (total_files == 0) total_files = 1;
 
@@ -180,18 +292,7 @@ int run_build_with_progress(const char *cmd, const char *source_dir) {
 
     scrollok(log_win, TRUE);
 
-   
-    char header_text[256];
-    snprintf(header_text, sizeof(header_text), "Alexia Kernel Installer Version %s", APP_VERSION);
-    int header_len = strnlen(header_text, sizeof(header_text));
-    int header_x = (width - header_len) / 2;
-    if (header_x < 0) header_x = 0;
-    
-    if (has_colors()) wattron(header_win, COLOR_PAIR(2) | A_BOLD);
-    mvwprintw(header_win, 0, header_x, "%s", header_text);
-    if (has_colors()) wattroff(header_win, COLOR_PAIR(2) | A_BOLD);
-    wrefresh(header_win);
-
+    draw_build_header(header_win, width);
    
     mvwhline(sep1_win, 0, 0, ACS_HLINE, width);
     wrefresh(sep1_win);
@@ -209,15 +310,27 @@ int run_build_with_progress(const char *cmd, const char *source_dir) {
         return -1;
     }
 
+    // select() sobre la salida de make y, con --background, sobre el teclado (+/-)
+    int build_fd = fileno(build_pipe);
+    int watch_keys = build_opts.background && isatty(STDIN_FILENO);
+    if (watch_keys) nodelay(header_win, TRUE);
+
+    char buf[4096];
     char line[1024];
+    size_t line_len = 0;
     int current_count = 0;
+    int last_percent = -1;
     int packaging_started = 0;
     char current_status_msg[256] = ""; 
 
     while (1) {
-        if (fgets(line, sizeof(line), build_pipe) == NULL) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(build_fd, &readfds);
+        if (watch_keys) FD_SET(STDIN_FILENO, &readfds);
+
+        if (select(build_fd + 1, &readfds, NULL, NULL, NULL) < 0) {
             if (errno == EINTR) {
-                clearerr(build_pipe);
                 endwin();
                 refresh(); 
                 getmaxyx(stdscr, height, width);
@@ -241,17 +354,7 @@ int run_build_with_progress(const char *cmd, const char *source_dir) {
                 wresize(bar_win, bar_height, width);
                 mvwin(bar_win, height - 1, 0);
 
-                
-                werase(header_win);
-                snprintf(header_text, sizeof(header_text), "Alexia Kernel Installer Version %s", APP_VERSION);
-                header_len = strnlen(header_text, sizeof(header_text));
-                header_x = (width - header_len) / 2;
-                if (header_x < 0) header_x = 0;
-                if (has_colors()) wattron(header_win, COLOR_PAIR(2) | A_BOLD);
-                mvwprintw(header_win, 0, header_x, "%s", header_text);
-                if (has_colors()) wattroff(header_win, COLOR_PAIR(2) | A_BOLD);
-                wrefresh(header_win);
-
+                draw_build_header(header_win, width);
       
                 werase(sep1_win);
                 mvwhline(sep1_win, 0, 0, ACS_HLINE, width);
@@ -276,110 +379,123 @@ int run_build_with_progress(const char *cmd, const char *source_dir) {
             }
             break;
         }
-        wprintw(log_win, "%s", line);
-        wrefresh(log_win);
-
-        if (strstr(line, " CC ") || strstr(line, " LD ") || strstr(line, " AR ")) {
-            current_count++;
-            int percent = (current_count * 100) / total_files;
-            if (percent > 100) percent = 100;
 
-            // Dibujar barra
-            werase(bar_win);
-            mvwprintw(bar_win, 0, 0, "%s [", _("Progress:"));
-            
-            int bar_width = width - 20; // Espacio para "Progress: " y " XXX%"
-            int filled_width = (percent * bar_width) / 100;
-            
-            if (has_colors()) wattron(bar_win, COLOR_PAIR(1));
-            for (int i = 0; i < bar_width; i++) {
-                if (i < filled_width) waddch(bar_win, '=');
-                else if (i == filled_width) waddch(bar_win, '>');
-                else waddch(bar_win, ' ');
+        if (watch_keys && FD_ISSET(STDIN_FILENO, &readfds)) {
+            int ch;
+            while ((ch = wgetch(header_win)) != ERR) {
+                if (background_handle_key(ch)) draw_build_header(header_win, width);
             }
-            if (has_colors()) wattroff(bar_win, COLOR_PAIR(1));
-            
-            wprintw(bar_win, "] %d%%", percent);
-            wrefresh(bar_win);
+        }
+        if (!FD_ISSET(build_fd, &readfds)) continue;
+
+        ssize_t r = read(build_fd, buf, sizeof(buf));
+        if (r < 0 && errno == EINTR) continue;
+        int eof = (r <= 0);
+        if (eof) {
+            if (line_len == 0) break;
+            buf[0] = '\n'; // la última línea, aunque no termine en salto
+            r = 1;
         }
 
-        
-        if (!packaging_started) {
-            if (strstr(line, "dpkg-deb: building package")) {
-                packaging_started = 1;
-                snprintf(current_status_msg, sizeof(current_status_msg), "%s", _("Building kernel and kernel headers .deb package. Please wait..."));
-                werase(bar_win);
-                if (has_colors()) wattron(bar_win, COLOR_PAIR(2) | A_BOLD);
-                mvwprintw(bar_win, 0, 0, "%s", current_status_msg);
-                if (has_colors()) wattroff(bar_win, COLOR_PAIR(2) | A_BOLD);
-                wrefresh(bar_win);
-            } else if (strstr(line, "Processing files:")) {
-                packaging_started = 1;
-                snprintf(current_status_msg, sizeof(current_status_msg), "%s", _("Building kernel .rpm package. Please wait..."));
+        for (ssize_t pos = 0; pos < r; pos++) {
+            line[line_len++] = buf[pos];
+            if (buf[pos] != '\n' && line_len < sizeof(line) - 1) continue;
+            line[line_len] = '\0';
+            line_len = 0;
+
+            wprintw(log_win, "%s", line);
+            wrefresh(log_win);
+
+            if (is_compile_line(line)) {
+                current_count++;
+                int percent = (current_count * 100) / total_files;
+                if (percent > 100) percent = 100;
+
+                // Dibujar barra
                 werase(bar_win);
-                if (has_colors()) wattron(bar_win, COLOR_PAIR(2) | A_BOLD);
-                mvwprintw(bar_win, 0, 0, "%s", current_status_msg);
-                if (has_colors()) wattroff(bar_win, COLOR_PAIR(2) | A_BOLD);
+                mvwprintw(bar_win, 0, 0, "%s [", _("Progress:"));
+                
+                int bar_width = width - 20; // Espacio para "Progress: " y " XXX%"
+                int filled_width = (percent * bar_width) / 100;
+                
+                if (has_colors()) wattron(bar_win, COLOR_PAIR(1));
+                for (int i = 0; i < bar_width; i++) {
+                    if (i < filled_width) waddch(bar_win, '=');
+                    else if (i == filled_width) waddch(bar_win, '>');
+                    else waddch(bar_win, ' ');
+                }
+                if (has_colors()) wattroff(bar_win, COLOR_PAIR(1));
+                
+                wprintw(bar_win, "] %d%%", percent);
                 wrefresh(bar_win);
             }
+            event_build_line(NULL, line, current_count, total_files, &last_percent);
+            footprint_sample();
+
+            
+            if (!packaging_started) {
+                if (strstr(line, "dpkg-deb: building package")) {
+                    packaging_started = 1;
+                    snprintf(current_status_msg, sizeof(current_status_msg), "%s", _("Building kernel and kernel headers .deb package. Please wait..."));
+                    werase(bar_win);
+                    if (has_colors()) wattron(bar_win, COLOR_PAIR(2) | A_BOLD);
+                    mvwprintw(bar_win, 0, 0, "%s", current_status_msg);
+                    if (has_colors()) wattroff(bar_win, COLOR_PAIR(2) | A_BOLD);
+                    wrefresh(bar_win);
+                } else if (strstr(line, "Processing files:")) {
+                    packaging_started = 1;
+                    snprintf(current_status_msg, sizeof(current_status_msg), "%s", _("Building kernel .rpm package. Please wait..."));
+                    werase(bar_win);
+                    if (has_colors()) wattron(bar_win, COLOR_PAIR(2) | A_BOLD);
+                    mvwprintw(bar_win, 0, 0, "%s", current_status_msg);
+                    if (has_colors()) wattroff(bar_win, COLOR_PAIR(2) | A_BOLD);
+                    wrefresh(bar_win);
+                }
+            }
         }
+        if (eof) break;
     }
 
     endwin(); // Restaurar terminal
     return pclose(build_pipe);
 }
 
-int check_and_install_whiptail(Distro distro) {
-    if (system("which whiptail > /dev/null 2>&1") != 0) {
-        printf(_("whiptail not found. Installing...\n"));
+int show_welcome_dialog() {
+    if (build_opts.headless) return 0;
 
-        DistroOperations* ops = get_distro_operations(distro);
-        if (!ops || !ops->get_whiptail_install_cmd) {
-            fprintf(stderr, _("Cannot install whiptail on this distribution\n"));
-            return -1;
-        }
+    char text[1024];
+    snprintf(text, sizeof(text), "%s %s\n\n%s\n\n%s\n\n%s?",
+             _("Alexia Kernel Installer Version"), APP_VERSION,
+             _("This program will download, compile and install the latest stable kernel from kernel.org."),
+             _("The process may take up to three hours in some systems."),
+             _("Do you wish to continue"));
 
-        if (system(ops->get_whiptail_install_cmd()) != 0) {
-            fprintf(stderr, _("Failed to install whiptail\n"));
-            return -1;
-        }
+    return dialog_yesno(_("Alexia Kernel Installer"), text, 60);
+}
 
-        printf(_("whiptail installed successfully. Restarting application...\n"));
-        execl("/proc/self/exe", "/proc/self/exe", NULL);
-        perror(_("Failed to restart"));
-        return -1;
+// Menú de presets. Devuelve el nombre elegido o "none" para usar solo la config de la distro
+const char* ask_preset() {
+    if (build_opts.headless) return "none";
+
+    const char *tags[8] = { "none" };
+    const char *items[8] = { _("Distribution configuration only") };
+    int count = 1;
+    for (int i = 0; kernel_presets[i].name != NULL && count < 8; i++, count++) {
+        tags[count] = kernel_presets[i].name;
+        items[count] = kernel_presets[i].description;
     }
-    return 0;
-}
 
-int show_welcome_dialog() {
-    char command[1024];
-    snprintf(command, sizeof(command),
-             "whiptail --title \"%s\" "
-             "--yesno \"%s " APP_VERSION "\\n\\n"
-             "%s\\n\\n"
-             "%s\\n\\n"
-             "%s?\" 15 60",
-             _("Alexia Kernel Installer"),
-             _("Alexia Kernel Installer Version"),
-             _("This program will download, compile and install the latest stable kernel from kernel.org."),
-             _("The process may take up to three hours in some systems."),
-             _("Do you wish to continue"));
-    
-    int result = system(command);
-    return result;
+    int choice = dialog_menu(_("Kernel Tuning Preset"), _("Choose a tuning preset for this kernel:"),
+                             tags, items, count, 76);
+    return (choice > 0) ? tags[choice] : "none";
 }
 
 int ask_cleanup() {
-    char command[512];
-    snprintf(command, sizeof(command),
-             "whiptail --title \"%s\" "
-             "--yesno \"%s?\" 10 50",
-             _("Cleanup Build Files"),
-             _("Do you want to clean up the build files"));
-    
-    int result = system(command);
-    return result;
+    if (build_opts.headless) return 1;
+
+    char text[256];
+    snprintf(text, sizeof(text), "%s?", _("Do you want to clean up the build files"));
+    return dialog_yesno(_("Cleanup Build Files"), text, 50);
 }
 
 // New function to check if kernel is already built, to skip rebuild if not necessary
@@ -431,40 +547,318 @@ int are_packages_built(const char *home, const char *version, const char *tag, D
         return (system(check_cmd) == 0);
         
     } else if (distro == DISTRO_FEDORA) {
-        // Check for .rpm packages
-        snprintf(package_path, sizeof(package_path),
-                 "%s/kernel_build/linux-%s/kernel-%s%s*.rpm", 
-                 home, version, version, tag);
-        
-        char check_cmd[1024];
-        snprintf(check_cmd, sizeof(check_cmd),
-                 "ls %s/kernel_build/linux-%s/kernel-%s%s*.rpm 2>/dev/null | grep -q .",
-                 home, version, version, tag);
-        
-        return (system(check_cmd) == 0);
+        // Check for .rpm packages (misma ubicación que usa fedora_install_packages)
+        return fedora_packages_built(home, version, tag);
     }
     
     return 0;
 }
 
+// Consulta kernel.org y devuelve la última versión de la rama pedida ("stable" o "longterm")
+int fetch_kernel_version(const char *moniker, char *out, size_t size) {
+    const char *marker = (strcmp(moniker, "longterm") == 0) ? "<td>longterm:</td>" : "latest_link";
+
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd),
+             "curl -s %s | "
+             "grep -A1 '%s' | grep -oE '[0-9]+\\.[0-9]+\\.[0-9]+' | "
+             "head -1", env_or_default("KERNEL_INSTALLER_RELEASES_URL", KERNEL_RELEASES_URL), marker);
+
+    FILE *fp = popen(cmd, "r");
+    if (!fp) return -1;
+
+    if (!fgets(out, size, fp)) {
+        pclose(fp);
+        return -1;
+    }
+    pclose(fp);
+
+    char *newline = strchr(out, '\n');
+    if (newline) *newline = '\0';
+
+    return (out[0] != '\0') ? 0 : -1;
+}
+
+// Descarga el tarball, o verifica el checksum del que ya existe
+void fetch_kernel_tarball(const char *home, const char *version) {
+    char cmd[1024];
+    // Check if kernel tarball already exists
+    char tarball_path[512];
+    snprintf(tarball_path, sizeof(tarball_path),
+             "%s/kernel_build/linux-%s.tar.xz", home, version);
+    
+    int need_download = 1;
+    struct stat st;
+    if (stat(tarball_path, &st) == 0) {
+        printf("Kernel source tarball already exists. Verifying checksum...\n");
+        
+        char expected_sha256[128];
+        if (get_kernel_sha256(version, expected_sha256, sizeof(expected_sha256)) == 0) {
+            if (verify_sha256(tarball_path, expected_sha256)) {
+                printf("Checksum verification passed. Kernel source already downloaded, reusing existing file.\n");
+                need_download = 0;
+            } else {
+                printf("Checksum verification failed. Existing file is corrupted or outdated.\n");
+                printf("Deleting existing file and downloading fresh copy from kernel.org...\n");
+                unlink(tarball_path);
+            }
+        } else {
+            printf("Warning: Could not verify checksum. Reusing existing file.\n");
+            need_download = 0;
+        }
+    }
+
+    // Descargar el kernel solo si es necesario
+    if (need_download) {
+        // curl en lugar de wget: también acepta espejos file://
+        snprintf(cmd, sizeof(cmd),
+                 "cd %s/kernel_build && "
+                 "curl -fL -o linux-%s.tar.xz %s/v%c.x/linux-%s.tar.xz",
+                 home, version, env_or_default("KERNEL_INSTALLER_MIRROR", KERNEL_MIRROR_URL),
+                 version[0], version);
+        run(cmd);
+    }
+}
+
+void extract_kernel_source(const char *home, const char *version) {
+    struct stat st;
+
+    // Check if source is already extracted
+    char source_dir[512];
+    snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, version);
+    
+    int need_extract = 1;
+    if (stat(source_dir, &st) == 0 && S_ISDIR(st.st_mode)) {
+        printf("Kernel source directory already exists. Skipping extraction.\n");
+        snapshot_break_links(source_dir);
+        need_extract = 0;
+    }
+
+    if (need_extract) snapshot_create_tree(source_dir, 0);
+}
+
+void fetch_kernel_source(const char *home, const char *version) {
+    fetch_kernel_tarball(home, version);
+    extract_kernel_source(home, version);
+}
+
+static const char* checkpoint_preset_name() {
+    return build_opts.preset ? build_opts.preset : "none";
+}
+
+// 1 si el perfil y el preset son los mismos con los que se configuró (un checkpoint
+// anterior que no los registraba se da por bueno)
+int checkpoint_inputs_match() {
+    if (checkpoint.profile[0] && strcmp(checkpoint.profile, profile_name(build_opts.profile)) != 0) return 0;
+    if (checkpoint.preset[0] && strcmp(checkpoint.preset, checkpoint_preset_name()) != 0) return 0;
+    return 1;
+}
+
+// Guarda el hash del .config, el perfil y el preset como entradas de las fases siguientes.
+// Lo llama también la compilación cuando tiene que cambiar el .config (vuelta a GCC,
+// árbol completo).
+void record_config_hash(const char *source_dir) {
+    snprintf(checkpoint.profile, sizeof(checkpoint.profile), "%s", profile_name(build_opts.profile));
+    snprintf(checkpoint.preset, sizeof(checkpoint.preset), "%s", checkpoint_preset_name());
+
+    char config_path[1024];
+    snprintf(config_path, sizeof(config_path), "%s/.config", source_dir);
+    if (file_sha256(config_path, checkpoint.config_sha256, sizeof(checkpoint.config_sha256)) != 0) {
+        checkpoint.config_sha256[0] = '\0';
+    }
+    checkpoint_save();
+}
+
+// Genera el .config a partir del kernel en ejecución y aplica tag, preset y perfil
+void configure_kernel_tree(const char *home, const char *version, const char *tag) {
+    char cmd[1024];
+    char source_dir[512];
+    snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, version);
+
+    // Lo que --direct recuerda de su última configuración deja de valer
+    snprintf(cmd, sizeof(cmd), "%s/" DIRECT_INPUTS_MARKER, source_dir);
+    unlink(cmd);
+
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && "
+             "cp %s .config && "
+             "yes \"\" | make %s oldconfig", source_dir,
+             env_or_default("KERNEL_INSTALLER_BASE_CONFIG", BASE_CONFIG_PATH), profile_make_vars());
+    if (extract_is_filtered(source_dir)) {
+        // Si el Kconfig necesita algo que no se extrajo, se reintenta con el árbol completo
+        printf("\n %s: %s\n", _("Running"), cmd);
+        if (system(cmd) != 0) {
+            extract_restore_full(source_dir);
+            run(cmd);
+        }
+    } else {
+        run(cmd);
+    }
+
+    snprintf(cmd, sizeof(cmd),
+             "cd %s && "
+             "sed -i 's/^CONFIG_LOCALVERSION=.*/CONFIG_LOCALVERSION=\"%s\"/' .config",
+             source_dir, tag);
+    run(cmd);
+
+    apply_preset(source_dir, build_opts.preset);
+    profile_apply_config(source_dir);
+    bootopt_apply_config(source_dir);
+
+    // Lo propio de la distro (Mint: certificados para firmar), antes de que se tome el hash
+    DistroOperations *ops = get_distro_operations(detect_distro());
+    if (ops && ops->configure_kernel) ops->configure_kernel(source_dir);
+}
+
 // New function to ask user about rebuild
 int ask_rebuild() {
-    char command[768];
-    snprintf(command, sizeof(command),
-             "whiptail --title \"%s\" "
-             "--yesno \"%s\\n\\n%s\\n\\n%s?\" 14 70",
-             "Kernel Already Built",
-             "The kernel appears to be already compiled in the build directory.",
-             "Building again will take 2-3 hours and may not be necessary.",
-             "Do you want to rebuild from scratch");
-    
-    return system(command);
+    if (build_opts.headless) return 1;
+
+    return dialog_yesno("Kernel Already Built",
+                        "The kernel appears to be already compiled in the build directory.\n\n"
+                        "Building again will take 2-3 hours and may not be necessary.\n\n"
+                        "Do you want to rebuild from scratch?", 70);
+}
+
+void print_usage(const char *prog) {
+    printf(_("Usage: %s [options]\n\n"), prog);
+    printf(_("Options:\n"));
+    printf(_("  --profile=NAME   build profile: default (GCC) or optimized (Clang ThinLTO, native CPU)\n"));
+    printf(_("  --preset=NAME    apply a tuning preset (or a path to a config fragment)\n"));
+    printf(_("  --list-presets   list the available tuning presets\n"));
+    printf(_("  --targets=LIST   build several kernels at once, e.g. stable,longterm,6.6.60\n"));
+    printf(_("  --boot-optimized strip and zstd-compress modules, minimal host-only initramfs\n"));
+    printf(_("  --headless       no dialogs; JSON-lines progress events on stdout\n"));
+    printf(_("  --progress-socket=PATH  also publish progress events on a Unix socket\n"));
+    printf(_("  --mok-key=TYPE   Secure Boot key type when a new one is needed: rsa or ecdsa (Mint/Ubuntu)\n"));
+    printf(_("  --watch          prebuild a new stable release in the background without installing it\n"));
+    printf(_("  --direct         incremental build installed straight to /boot, without packages (dev loop)\n"));
+    printf(_("  --perf-check     compare the new kernel's microbenchmarks with the previous kernel and exit\n"));
+    printf(_("  --skip-space-check  build even if the disk space estimate says it will not fit\n"));
+    printf(_("  --background     limit the build's CPU and I/O use (cgroup, or nice/ionice); +/- adjust it live\n"));
+    printf(_("  --help           show this help and exit\n"));
+    printf(_("  --version        show version and exit\n"));
+}
+
+// Devuelve 0 para continuar, 1 si hay que salir sin error y -1 ante opciones inválidas
+int parse_arguments(int argc, char *argv[]) {
+    static struct option long_options[] = {
+        {"profile", required_argument, NULL, 'p'},
+        {"preset",  required_argument, NULL, 'P'},
+        {"list-presets", no_argument,  NULL, 'L'},
+        {"targets", required_argument, NULL, 'T'},
+        {"boot-optimized", no_argument, NULL, 'B'},
+        {"headless", no_argument,      NULL, 'H'},
+        {"progress-socket", required_argument, NULL, 'S'},
+        {"mok-key", required_argument, NULL, 'K'},
+        {"background", no_argument,    NULL, 'G'},
+        {"watch",   no_argument,       NULL, 'W'},
+        {"perf-check", no_argument,    NULL, 'C'},
+        {"direct",  no_argument,       NULL, 'D'},
+        {"skip-space-check", no_argument, NULL, 'F'},
+        {"help",    no_argument,       NULL, 'h'},
+        {"version", no_argument,       NULL, 'V'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p':
+                if (strcmp(optarg, "optimized") == 0) {
+                    build_opts.profile = PROFILE_OPTIMIZED;
+                } else if (strcmp(optarg, "default") == 0) {
+                    build_opts.profile = PROFILE_DEFAULT;
+                } else {
+                    fprintf(stderr, _("Unknown build profile: %s\n"), optarg);
+                    return -1;
+                }
+                break;
+            case 'P':
+                if (strcmp(optarg, "none") != 0 && !preset_exists(optarg)) {
+                    fprintf(stderr, _("Unknown preset: %s\n"), optarg);
+                    list_presets();
+                    return -1;
+                }
+                if (preset_is_file(optarg)) {
+                    // Los comandos corren dentro del árbol del kernel: necesitamos la ruta absoluta
+                    static char fragment_path[PATH_MAX];
+                    if (!realpath(optarg, fragment_path)) {
+                        perror(optarg);
+                        return -1;
+                    }
+                    build_opts.preset = fragment_path;
+                } else {
+                    build_opts.preset = optarg;
+                }
+                break;
+            case 'L':
+                list_presets();
+                return 1;
+            case 'T':
+                build_opts.targets = optarg;
+                break;
+            case 'B':
+                build_opts.boot_optimized = 1;
+                break;
+            case 'H':
+                build_opts.headless = 1;
+                break;
+            case 'S':
+                build_opts.progress_socket = optarg;
+                break;
+            case 'K':
+                if (strcmp(optarg, "rsa") != 0 && strcmp(optarg, "ecdsa") != 0) {
+                    fprintf(stderr, _("Unknown key type: %s (use rsa or ecdsa)\n"), optarg);
+                    return -1;
+                }
+                build_opts.mok_key_type = optarg;
+                break;
+            case 'G':
+                build_opts.background = 1;
+                break;
+            case 'W':
+                // Corre desatendido y sin molestar a lo que esté usando el equipo
+                build_opts.watch = 1;
+                build_opts.headless = 1;
+                build_opts.background = 1;
+                break;
+            case 'C':
+                build_opts.perf_check = 1;
+                break;
+            case 'D':
+                build_opts.direct = 1;
+                break;
+            case 'F':
+                build_opts.skip_space_check = 1;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 1;
+            case 'V':
+                printf("kernel-installer %s\n", APP_VERSION);
+                return 1;
+            default:
+                print_usage(argv[0]);
+                return -1;
+        }
+    }
+
+    if (build_opts.watch && build_opts.targets) {
+        fprintf(stderr, _("--watch prepares a single stable kernel and cannot be combined with --targets\n"));
+        return -1;
+    }
+    if (build_opts.direct && (build_opts.targets || build_opts.watch)) {
+        fprintf(stderr, _("--direct cannot be combined with --targets or --watch\n"));
+        return -1;
+    }
+    return 0;
 }
 
 // ========== FIN DE FUNCIONES AUXILIARES ==========
 
 Distro detect_distro() {
-    FILE *fp = fopen("/etc/os-release", "r");
+    FILE *fp = fopen(env_or_default("KERNEL_INSTALLER_OS_RELEASE", OS_RELEASE_PATH), "r");
     if (!fp) return DISTRO_UNKNOWN;
     
     char line[256];
@@ -526,28 +920,34 @@ void handle_secure_boot_enrollment(Distro distro) {
 }
 
 void show_completion_dialog(const char *kernel_version, Distro distro) {
-    char command[1024];
-    snprintf(command, sizeof(command),
-             "whiptail --title \"%s\" "
-             "--yes-button \"%s\" --no-button \"%s\" "
-             "--yesno \"%s %s.\\n\\n%s.\\n\\n"
-             "%s.\" 14 60", 
-             _("Installation Complete"),
-             _("Reboot Now"),
-             _("Reboot Later"),
-             _("Kernel"),
-             kernel_version,
-             _("has been successfully installed"),
-             _("If you enrolled Secure Boot, complete the enrollment during reboot"));
-    
-    int result = system(command);
-    
-    if (result == 0) {
-        printf(_("Rebooting system...\n"));
+    const char *choice = "later";
+    if (!build_opts.headless) {
+        char text[1024];
+        snprintf(text, sizeof(text), "%s %s.\n\n%s.\n\n%s.",
+                 _("Kernel"), kernel_version,
+                 _("has been successfully installed"),
+                 _("If you enrolled Secure Boot, complete the enrollment during reboot"));
+
+        const char *tags[] = { "reboot", "fast", "later" };
+        const char *items[] = {
+            _("Reboot Now"),
+            _("Fast reboot (kexec, skips firmware POST)"),
+            _("Reboot Later")
+        };
+        int selected = dialog_menu(_("Installation Complete"), text, tags, items, 3, 70);
+        if (selected >= 0) choice = tags[selected];
+    }
+
+    if (strcmp(choice, "reboot") == 0) {
         if (distro == DISTRO_MINT) {
             printf(_("Remember: If you enrolled Secure Boot, look for the blue MOK Manager screen!\n"));
         }
-        system("sudo reboot");
+        normal_reboot();
+    } else if (strcmp(choice, "fast") == 0) {
+        // En modo multi-target se arranca el primer kernel de la lista
+        char first[128];
+        snprintf(first, sizeof(first), "%.*s", (int)strcspn(kernel_version, ", "), kernel_version);
+        kexec_fast_reboot(get_distro_operations(distro), first);
     } else {
         printf("\n%s\n", _("Remember to reboot the machine to boot with the latest kernel"));
         if (distro == DISTRO_MINT) {
@@ -559,13 +959,167 @@ void show_completion_dialog(const char *kernel_version, Distro distro) {
     }
 }
 
-int main(void) {
+// Flujo de una sola versión, por fases. Cada fase terminada queda en el checkpoint,
+// así que al volver a ejecutar se retoma en la que falló.
+void run_single_target(const char *home, DistroOperations *ops, Distro distro, const char *tag,
+                       char *full_kernel_version, size_t full_kernel_version_size) {
+    char latest[32];
+    struct stat st;
+
+    if (checkpoint.version[0]) {
+        // Retomamos con la misma versión aunque kernel.org ya publique otra
+        snprintf(latest, sizeof(latest), "%s", checkpoint.version);
+        if (checkpoint.tag[0]) tag = checkpoint.tag;
+    } else {
+        // Descargar la versión más reciente del kernel
+        printf(_("Fetching latest kernel version from kernel.org...\n"));
+
+        if (fetch_kernel_version("stable", latest, sizeof(latest)) != 0) {
+            fprintf(stderr, _("Could not fetch latest kernel version.\n"));
+            exit(EXIT_FAILURE);
+        }
+        snprintf(checkpoint.version, sizeof(checkpoint.version), "%s", latest);
+        snprintf(checkpoint.tag, sizeof(checkpoint.tag), "%s", tag);
+    }
+
+    printf(_("Latest stable kernel: %s\n"), latest);
+    snprintf(full_kernel_version, full_kernel_version_size, "%s%s", latest, tag);
+
+    char source_dir[512];
+    snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, latest);
+    int have_source = (stat(source_dir, &st) == 0 && S_ISDIR(st.st_mode));
+
+    // Validar las entradas y salidas de las fases ya terminadas antes de confiar en ellas
+    int inputs_changed = checkpoint_done(PHASE_CONFIGURE) && !checkpoint_inputs_match();
+    if (inputs_changed) {
+        printf(_("The build profile or preset changed since the last run (was %s, %s), configuring again.\n"),
+               checkpoint.profile, checkpoint.preset);
+        checkpoint_invalidate_from(PHASE_CONFIGURE);
+    }
+    if (checkpoint_done(PHASE_BUILD) && !are_packages_built(home, latest, tag, distro)) {
+        printf(_("Built packages are missing, building again.\n"));
+        checkpoint_invalidate_from(PHASE_BUILD);
+    }
+    if (!checkpoint_done(PHASE_BUILD) && checkpoint_done(PHASE_EXTRACT) && !have_source) {
+        printf(_("Kernel source directory is missing, extracting again.\n"));
+        checkpoint_invalidate_from(PHASE_EXTRACT);
+    }
+    if (!checkpoint_done(PHASE_BUILD) && checkpoint_done(PHASE_CONFIGURE)) {
+        char recorded[72];
+        snprintf(recorded, sizeof(recorded), "%s", checkpoint.config_sha256);
+        record_config_hash(source_dir);
+        if (strcmp(recorded, checkpoint.config_sha256) != 0) {
+            printf(_(".config changed since it was generated, configuring again.\n"));
+            checkpoint_invalidate_from(PHASE_CONFIGURE);
+        }
+    }
+
+    if (!checkpoint_done(PHASE_FETCH)) {
+        checkpoint_begin(PHASE_FETCH);
+        fetch_kernel_tarball(home, latest);
+        checkpoint_complete(PHASE_FETCH);
+    }
+
+    if (!checkpoint_done(PHASE_EXTRACT)) {
+        checkpoint_begin(PHASE_EXTRACT);
+        extract_kernel_source(home, latest);
+        checkpoint_complete(PHASE_EXTRACT);
+    }
+
+    // Sin checkpoint que lo diga, detectamos una compilación anterior y preguntamos
+    // (si cambiaron perfil o preset, la que hay no sirve: se reconfigura y make recompila)
+    if (!checkpoint_done(PHASE_CONFIGURE) && !inputs_changed) {
+        int kernel_already_built = is_kernel_built(source_dir, latest, tag);
+        int packages_already_built = are_packages_built(home, latest, tag, distro);
+        
+        if (kernel_already_built || packages_already_built) {
+            printf("\n========================================\n");
+            if (kernel_already_built) {
+                printf("Compiled kernel binary (vmlinuz) detected in build directory.\n");
+            }
+            if (packages_already_built) {
+                printf("Installation packages (.deb/.rpm) already exist in build directory.\n");
+            }
+            printf("Build appears to be complete.\n");
+            printf("========================================\n\n");
+            
+            if (ask_rebuild() != 0) {
+                printf("Skipping rebuild. Using existing compiled kernel.\n");
+
+                // Con los paquetes ya generados pasamos directo a instalar;
+                // si solo está compilado, make termina de empaquetar sin recompilar
+                record_config_hash(source_dir);
+                checkpoint_complete(PHASE_CONFIGURE);
+                if (packages_already_built) {
+                    printf("Proceeding directly to installation...\n\n");
+                    checkpoint_complete(PHASE_BUILD);
+                }
+            } else {
+                printf("User chose to rebuild. Starting clean build...\n");
+                // Un árbol nuevo desde el prístino es más rápido que make mrproper
+                snapshot_create_tree(source_dir, 0);
+            }
+        }
+    }
+
+    if (!checkpoint_done(PHASE_CONFIGURE)) {
+        checkpoint_begin(PHASE_CONFIGURE);
+        configure_kernel_tree(home, latest, tag);
+        record_config_hash(source_dir);
+        checkpoint_complete(PHASE_CONFIGURE);
+    }
+
+    if (!checkpoint_done(PHASE_BUILD)) {
+        char build_dir[512];
+        Footprint footprint;
+        snprintf(build_dir, sizeof(build_dir), "%s/kernel_build", home);
+        footprint_estimate(home, latest, source_dir, footprint_format(distro), &footprint);
+        footprint_preflight(build_dir, &footprint);
+
+        checkpoint_begin(PHASE_BUILD);
+        printf(_("Building kernel for %s...\n"), ops->name);
+        footprint_begin(build_dir);
+        ops->build_packages(home, latest, tag);
+        footprint_finish(home, latest, &footprint);
+        // --watch en Mint solo compila: firmar y empaquetar quedan para la ejecución interactiva
+        if (build_opts.watch && !are_packages_built(home, latest, tag, distro)) return;
+        checkpoint_complete(PHASE_BUILD);
+    }
+
+    // --watch deja los paquetes listos; instalar queda para la ejecución interactiva
+    if (build_opts.watch) return;
+
+    if (!checkpoint_done(PHASE_INSTALL)) {
+        checkpoint_begin(PHASE_INSTALL);
+        printf(_("Installing kernel packages for %s...\n"), ops->name);
+        perf_record_baseline(home, full_kernel_version);
+        time_t install_start = time(NULL);
+        bootopt_begin_install(ops);
+        ops->install_packages(home, latest, tag);
+        bootopt_finish_install(ops, full_kernel_version);
+        record_install_seconds(home, full_kernel_version, (long)(time(NULL) - install_start));
+        checkpoint_complete(PHASE_INSTALL);
+    }
+}
+
+int main(int argc, char *argv[]) {
     setlocale(LC_ALL, "");
     
     if (bindtextdomain("kernel-install", "./locale") == NULL) {
         bindtextdomain("kernel-install", "/usr/local/share/locale");
     }
     textdomain("kernel-install");
+
+    int args = parse_arguments(argc, argv);
+    if (args != 0) {
+        return (args > 0) ? 0 : EXIT_FAILURE;
+    }
+
+    // A partir de aquí, en modo --headless stdout solo lleva eventos JSON
+    if (events_init(build_opts.headless, build_opts.progress_socket) != 0) {
+        return EXIT_FAILURE;
+    }
+    background_init();
     
     const char *TAG = "-lexi-amd64";
     const char *home = getenv("HOME");
@@ -575,6 +1129,19 @@ int main(void) {
         exit(EXIT_FAILURE);
     }
 
+    // Si venimos de un reinicio rápido, informar cuánto tardó
+    kexec_report_handoff(home);
+
+    // Primer arranque con un kernel recién instalado: comparar con la línea base del anterior.
+    // No con --watch, que corre desde un timer y no debe cargar la máquina con los benchmarks.
+    if (build_opts.perf_check || !build_opts.watch) {
+        int regressions = perf_check_pending(home, build_opts.perf_check);
+        if (build_opts.perf_check) {
+            event_result(regressions ? "failed" : "ok", NULL);
+            return regressions ? EXIT_FAILURE : 0;
+        }
+    }
+
     // Detectar distribución y obtener operaciones
     Distro distro = detect_distro();
     DistroOperations* ops = get_distro_operations(distro);
@@ -586,15 +1153,16 @@ int main(void) {
     
     printf(_("Detected distribution: %s\n"), ops->name);
     
-    if (check_and_install_whiptail(distro) != 0) {
-        fprintf(stderr, _("Whiptail installation failed. Continuing with text mode...\n"));
-    }
-    
     if (show_welcome_dialog() != 0) {
         printf(_("Installation cancelled by user.\n"));
+        event_result("cancelled", NULL);
         return 0;
     }
 
+    if (build_opts.preset == NULL) {
+        build_opts.preset = ask_preset();
+    }
+
     char build_dir[512];
     snprintf(build_dir, sizeof(build_dir), "%s/kernel_build", home);
     printf(_("Creating build directory: %s\n"), build_dir);
@@ -614,179 +1182,108 @@ int main(void) {
         }
     }
 
-    // Instalar las dependencias específicas de la distribución
-    printf(_("Installing required packages for %s...\n"), ops->name);
-    ops->install_dependencies();
-
-    // Para Mint/Ubuntu: generar certificado GoldenDogLinux
-    if (distro == DISTRO_MINT) {
-        mint_generate_certificate();
-    }
-
-
-    // Descargar la versión más reciente del kernel
-    printf(_("Fetching latest kernel version from kernel.org...\n"));
-
-    char tmp_file[512];
-    snprintf(tmp_file, sizeof(tmp_file), "%s/kernel_build/kernelver.txt", home);
-    
-    char fetch_cmd[1024];
-    snprintf(fetch_cmd, sizeof(fetch_cmd),
-             "curl -s https://www.kernel.org/ | "
-             "grep -A1 'latest_link' | grep -oE '[0-9]+\\.[0-9]+\\.[0-9]+' | "
-             "head -1 > %s", tmp_file);
-    run(fetch_cmd);
-
-    FILE *f = fopen(tmp_file, "r");
-    if (!f) {
-        fprintf(stderr, _("Could not fetch latest kernel version.\n"));
-        exit(EXIT_FAILURE);
-    }
-
-    char latest[32];
-    if (!fgets(latest, sizeof(latest), f)) {
-        fprintf(stderr, _("Empty version string.\n"));
-        fclose(f);
+    // Una sola ejecución por vez sobre ~/kernel_build (interactiva o --watch)
+    if (acquire_build_lock(build_dir) < 0) {
+        if (build_opts.watch) {
+            printf(_("Another kernel-installer run is using %s, nothing to do.\n"), build_dir);
+            event_result("skipped", NULL);
+            return 0;
+        }
+        fprintf(stderr, _("Another kernel-installer run (or the --watch prebuild) is using %s. "
+                          "Wait for it to finish or stop it with: systemctl --user stop kernel-installer-watch.service\n"),
+                build_dir);
         exit(EXIT_FAILURE);
     }
-    fclose(f);
 
-    char *newline = strchr(latest, '\n');
-    if (newline) {
-        *newline = '\0';
+    if (build_opts.watch) {
+        int pending = watch_check_release(home, TAG, distro);
+        if (pending <= 0) {
+            event_result(pending == 0 ? "skipped" : "failed", NULL);
+            return (pending == 0) ? 0 : EXIT_FAILURE;
+        }
+    } else if (!build_opts.targets && !build_opts.direct && checkpoint_load(home)) {
+        // Retomar una ejecución que quedó a medias (el modo multi-target no usa checkpoint)
+        checkpoint_print_resume();
     }
 
-    printf(_("Latest stable kernel: %s\n"), latest);
+    if (!checkpoint_done(PHASE_DEPENDENCIES)) {
+        checkpoint_begin(PHASE_DEPENDENCIES);
+        // Instalar las dependencias específicas de la distribución
+        printf(_("Installing required packages for %s...\n"), ops->name);
+        ops->install_dependencies();
 
-  
-    char cmd[1024];
-    // Check if kernel tarball already exists
-    char tarball_path[512];
-    snprintf(tarball_path, sizeof(tarball_path),
-             "%s/kernel_build/linux-%s.tar.xz", home, latest);
-    
-    int need_download = 1;
-    struct stat st;
-    if (stat(tarball_path, &st) == 0) {
-        printf("Kernel source tarball already exists. Verifying checksum...\n");
-        
-        char expected_sha256[128];
-        if (get_kernel_sha256(latest, expected_sha256, sizeof(expected_sha256)) == 0) {
-            if (verify_sha256(tarball_path, expected_sha256)) {
-                printf("Checksum verification passed. Kernel source already downloaded, reusing existing file.\n");
-                need_download = 0;
-            } else {
-                printf("Checksum verification failed. Existing file is corrupted or outdated.\n");
-                printf("Deleting existing file and downloading fresh copy from kernel.org...\n");
-                unlink(tarball_path);
-            }
-        } else {
-            printf("Warning: Could not verify checksum. Reusing existing file.\n");
-            need_download = 0;
+        // Para Mint/Ubuntu: generar certificado GoldenDogLinux. --watch no tiene root:
+        // lo hace la ejecución interactiva al firmar (mint_build_packages)
+        if (distro == DISTRO_MINT && !build_opts.watch) {
+            mint_generate_certificate();
         }
+        checkpoint_complete(PHASE_DEPENDENCIES);
     }
 
-    // Descargar el kernel solo si es necesario
-    if (need_download) {
-        snprintf(cmd, sizeof(cmd),
-                 "cd %s/kernel_build && "
-                 "wget -O linux-%s.tar.xz https://cdn.kernel.org/pub/linux/kernel/v%c.x/linux-%s.tar.xz",
-                 home, latest, latest[0], latest);
-        run(cmd);
-    }
+    // Perfil optimizado: comprobar el toolchain antes de configurar
+    profile_resolve();
 
-    // Check if source is already extracted
-    char source_dir[512];
-    snprintf(source_dir, sizeof(source_dir), "%s/kernel_build/linux-%s", home, latest);
-    
-    int need_extract = 1;
-    if (stat(source_dir, &st) == 0 && S_ISDIR(st.st_mode)) {
-        printf("Kernel source directory already exists. Skipping extraction.\n");
-        need_extract = 0;
-    }
+    char full_kernel_version[256];
+    char cmd[1024];
 
-    if (need_extract) {
-        snprintf(cmd, sizeof(cmd),
-                 "cd %s/kernel_build && tar -xf linux-%s.tar.xz", home, latest);
-        run(cmd);
+    if (build_opts.targets) {
+        // Modo multi-target: varias versiones compiladas en paralelo
+        run_multi_target(home, ops, distro, full_kernel_version, sizeof(full_kernel_version));
+    } else if (build_opts.direct) {
+        // Ciclo de desarrollo: make incremental e instalación directa, sin paquetes
+        run_direct_target(home, ops, distro, TAG, full_kernel_version, sizeof(full_kernel_version));
+    } else {
+        run_single_target(home, ops, distro, TAG, full_kernel_version, sizeof(full_kernel_version));
     }
 
-    // Check if kernel is already built
-    int kernel_already_built = is_kernel_built(source_dir, latest, TAG);
-    int packages_already_built = are_packages_built(home, latest, TAG, distro);
-    
-    if (kernel_already_built || packages_already_built) {
-        printf("\n========================================\n");
-        if (kernel_already_built) {
-            printf("Compiled kernel binary (vmlinuz) detected in build directory.\n");
-        }
-        if (packages_already_built) {
-            printf("Installation packages (.deb/.rpm) already exist in build directory.\n");
-        }
-        printf("Build appears to be complete.\n");
-        printf("========================================\n\n");
-        
-        if (ask_rebuild() != 0) {
-            printf("Skipping rebuild. Using existing compiled kernel.\n");
-            printf("Proceeding directly to installation...\n\n");
-            
-            // Skip to installation phase
-            goto install_phase;
+    if (build_opts.watch) {
+        if (checkpoint_done(PHASE_BUILD)) {
+            printf(_("Packages for %s are ready. Run kernel-installer to install them.\n"), full_kernel_version);
         } else {
-            printf("User chose to rebuild. Starting clean build...\n");
-            // Clean the build directory
-            snprintf(cmd, sizeof(cmd),
-                     "cd %s/kernel_build/linux-%s && make mrproper",
-                     home, latest);
-            run(cmd);
+            printf(_("Kernel %s is compiled. Run kernel-installer to sign its modules, package and install it.\n"),
+                   full_kernel_version);
         }
+        event_result("ok", full_kernel_version);
+        return 0;
     }
 
-    snprintf(cmd, sizeof(cmd),
-             "cd %s/kernel_build && tar -xf linux-%s.tar.xz", home, latest);
-    run(cmd);
-
-   
-    snprintf(cmd, sizeof(cmd),
-             "cd %s/kernel_build/linux-%s && "
-             "cp /boot/config-$(uname -r) .config && "
-             "yes \"\" | make oldconfig", home, latest);
-    run(cmd);
-
-    snprintf(cmd, sizeof(cmd),
-             "cd %s/kernel_build/linux-%s && "
-             "sed -i 's/^CONFIG_LOCALVERSION=.*/CONFIG_LOCALVERSION=\"%s\"/' .config",
-             home, latest, TAG);
-    run(cmd);
-
-
-    printf(_("Building and installing kernel for %s...\n"), ops->name);
-    ops->build_and_install(home, latest, TAG);
-
-install_phase:
-    // Actualizar bootloader
-    printf(_("Updating bootloader for %s...\n"), ops->name);
-    ops->update_bootloader();
+    if (!checkpoint_done(PHASE_BOOTLOADER)) {
+        checkpoint_begin(PHASE_BOOTLOADER);
+        // Actualizar bootloader
+        printf(_("Updating bootloader for %s...\n"), ops->name);
+        ops->update_bootloader();
+        checkpoint_complete(PHASE_BOOTLOADER);
+    }
 
-    // Para Mint/Ubuntu: ofrecer enrolamiento Secure Boot
-    if (distro == DISTRO_MINT) {
-        if (mint_ask_secure_boot_enrollment() == 0) {
-            mint_enroll_secure_boot_key();
-        } else {
-            printf(_("Secure Boot enrollment skipped.\n"));
-            printf(_("You can enroll the certificate later with: sudo mokutil --import /var/lib/shim-signed/mok/MOK_goldendoglinux.der\n"));
+    // En --direct la clave MOK no cambia entre vueltas: no se ofrece enrolarla cada vez
+    if (!build_opts.direct && !checkpoint_done(PHASE_SECURE_BOOT)) {
+        checkpoint_begin(PHASE_SECURE_BOOT);
+        // Para Mint/Ubuntu: ofrecer enrolamiento Secure Boot
+        if (distro == DISTRO_MINT) {
+            if (mint_ask_secure_boot_enrollment() == 0) {
+                mint_enroll_secure_boot_key();
+            } else {
+                printf(_("Secure Boot enrollment skipped.\n"));
+                printf(_("You can enroll the certificate later with: sudo mokutil --import /var/lib/shim-signed/mok/MOK_goldendoglinux.der\n"));
+            }
         }
+        checkpoint_complete(PHASE_SECURE_BOOT);
     }
 
-    // Limpieza
-    if (ask_cleanup() == 0) {
-        snprintf(cmd, sizeof(cmd), "rm -rf %s/kernel_build", home);
+    // Todas las fases terminaron: la próxima ejecución empieza de cero
+    checkpoint_clear();
+
+    // Limpieza (en --direct el árbol compilado es justamente lo que se reutiliza)
+    if (!build_opts.direct && ask_cleanup() == 0) {
+        // Conservamos los registros (*.log) y las mediciones de perf/ para poder comparar
+        snprintf(cmd, sizeof(cmd),
+                 "find %s/kernel_build -mindepth 1 -maxdepth 1 ! -name '*.log' ! -name " BUILD_LOCK_FILE
+                 " ! -name " PERF_DIR_NAME " -exec rm -rf {} +", home);
         run(cmd);
         printf(_("Build files cleaned up.\n"));
     }
 
-    char full_kernel_version[64];
-    snprintf(full_kernel_version, sizeof(full_kernel_version), "%s%s", latest, TAG);
+    event_result("ok", full_kernel_version);
     show_completion_dialog(full_kernel_version, distro);
 
     return 0;